@@ -0,0 +1,148 @@
+/** Alpha complex and alpha shapes of a Delaunay triangulation.
+ *  See AlphaComplex.h */
+
+#include "AlphaComplex.h"
+#include "utils/misc.h"
+#include <algorithm>
+#include <limits>
+#include <iostream>
+
+using namespace Eigen;
+using namespace std;
+
+
+/** Sorts the indices 0..KEY.size()-1 by KEY (ties by index). */
+static void sortedOrder(const vector<double> &key, vector<int> &order) {
+	vector<pair<double,int> > keyed(key.size());
+	for (int i = 0; i < key.size(); i += 1) keyed[i] = make_pair(key[i], i);
+	sort(keyed.begin(), keyed.end());
+	order.resize(key.size());
+	for (int i = 0; i < order.size(); i += 1) order[i] = keyed[i].second;
+}
+
+
+/** The vertex of the triangle TRI which is neither A nor B. */
+static inline int apex(const int *tri, int a, int b) {
+	return (tri[0] != a && tri[0] != b)? tri[0] : ((tri[1] != a && tri[1] != b)? tri[1] : tri[2]);
+}
+
+
+/** Computes and sorts the critical alphas of SUB, in one pass. */
+AlphaComplex::AlphaComplex(DelaunaySubdivision *sub, bool time) {
+	if (!sub->randEdge) {
+		cout << "Alpha complex : compute the triangulation first. Exiting.\n";
+		exit(-1);
+	}
+	const double inf = numeric_limits<double>::infinity();
+	double tim = wallTime();
+
+	// the faces are numbered by computeVoronoi : e->RotInv()->org() is the
+	// left face of e (or -1), and its circumcenter is in voronoi_vertices.
+	vector<QuadEdge::Ptr> qedges;
+	const int F = sub->computeVoronoi(qedges);
+
+	// each triangle once, from the first of its edges met.
+	vector<double> alpha(F, -1.0);
+	vector<int> verts(3*F);
+	for (int i = 0; i < qedges.size(); i += 1) {
+		for (int k = 0; k < 4; k += 2) {
+			Edge::Ptr s = qedges[i]->edges[k];
+			const int f = s->RotInv()->org();
+			if (f < 0 || alpha[f] >= 0.0) continue;
+			verts[3*f] = s->org(); verts[3*f+1] = s->dest(); verts[3*f+2] = s->Onext()->dest();
+			const Vector2d c(sub->voronoi_vertices(f,0), sub->voronoi_vertices(f,1));
+			alpha[f] = (c - *sub->point_ptrs[s->org()]).squaredNorm();
+		}
+	}
+
+	vector<double> lo(qedges.size()), mid(qedges.size()), hi(qedges.size());
+	vector<int> ends(2*qedges.size());
+	for (int i = 0; i < qedges.size(); i += 1) {
+		Edge::Ptr e = qedges[i]->edges[0];
+		int a = e->org(), b = e->dest();
+		int fl = e->RotInv()->org(), fr = e->Rot()->org();
+
+		// the triangle which enters first goes on the left.
+		double al = (fl >= 0)? alpha[fl] : inf, ar = (fr >= 0)? alpha[fr] : inf;
+		if (ar < al) {
+			swap(a, b); swap(fl, fr); swap(al, ar);
+		}
+		const Vector2d &pa = *sub->point_ptrs[a], &pb = *sub->point_ptrs[b];
+		bool gabriel = true;
+		for (int f = fl; f >= 0 && gabriel; f = (f == fl)? fr : -1)
+			gabriel = indiametral(pa, pb, *sub->point_ptrs[apex(&verts[3*f], a, b)]) <= 0.0;
+
+		ends[2*i] = a; ends[2*i+1] = b;
+		lo[i]  = gabriel? 0.25 * (pb - pa).squaredNorm() : al;
+		mid[i] = al;
+		hi[i]  = ar;
+	}
+	const double tim_alpha = wallTime() - tim;
+
+	tim = wallTime();
+	vector<int> order;
+	sortedOrder(alpha, order);
+	tri_alpha.resize(F);
+	tri_verts.resize(3*F);
+	for (int i = 0; i < F; i += 1) {
+		const int f = order[i];
+		tri_alpha[i] = alpha[f];
+		for (int k = 0; k < 3; k += 1) tri_verts[3*i+k] = verts[3*f+k];
+	}
+
+	sortedOrder(lo, order);
+	const int E = order.size();
+	edge_lo.resize(E); edge_mid.resize(E); edge_hi.resize(E);
+	edge_verts.resize(2*E);
+	for (int i = 0; i < E; i += 1) {
+		const int j = order[i];
+		edge_lo[i] = lo[j]; edge_mid[i] = mid[j]; edge_hi[i] = hi[j];
+		edge_verts[2*i] = ends[2*j]; edge_verts[2*i+1] = ends[2*j+1];
+	}
+	if (time) {
+		cout <<">>> alpha complex : "<<tim_alpha<<" seconds for the critical alphas, "
+			 <<wallTime()-tim<<" seconds to sort "<<E<<" edges and "<<F<<" triangles.\n";
+	}
+}
+
+
+/** Number of triangles in the complex for ALPHA. */
+int AlphaComplex::numTriangles(double alpha) const {
+	return upper_bound(tri_alpha.begin(), tri_alpha.end(), alpha) - tri_alpha.begin();
+}
+
+
+/** Appends the triangles of the complex for ALPHA to TRIS. */
+void AlphaComplex::triangles(double alpha, vector<int> &tris) const {
+	tris.insert(tris.end(), tri_verts.begin(), tri_verts.begin() + 3*numTriangles(alpha));
+}
+
+
+/** Appends the boundary edges of the alpha shape to EDGES : regular ones
+ *  first, then (with SINGULAR) the singular ones. */
+int AlphaComplex::boundary(double alpha, vector<int> &edges, bool singular) const {
+	const int n = upper_bound(edge_lo.begin(), edge_lo.end(), alpha) - edge_lo.begin();
+	vector<int> lone;
+	int regular = 0;
+	for (int i = 0; i < n; i += 1) {
+		if (edge_hi[i] <= alpha) continue; // interior
+		if (edge_mid[i] <= alpha) {
+			edges.push_back(edge_verts[2*i]);
+			edges.push_back(edge_verts[2*i+1]);
+			regular += 1;
+		} else if (singular) {
+			lone.push_back(edge_verts[2*i]);
+			lone.push_back(edge_verts[2*i+1]);
+		}
+	}
+	edges.insert(edges.end(), lone.begin(), lone.end());
+	return regular;
+}
+
+
+/** The smallest alpha for which the complex is the whole triangulation. */
+double AlphaComplex::maxAlpha() const {
+	double a = tri_alpha.empty()? 0.0 : tri_alpha.back();
+	if (!edge_lo.empty()) a = max(a, edge_lo.back());
+	return a;
+}
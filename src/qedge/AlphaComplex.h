@@ -0,0 +1,65 @@
+/** Alpha complex and alpha shapes of a Delaunay triangulation
+ *  (Edelsbrunner, Kirkpatrick and Seidel [1983], Edelsbrunner and Muecke [1994]).
+ *
+ *  Alpha is a squared radius. A triangle is in the complex from its squared
+ *  circumradius on. An edge is in it from its squared half length on if it
+ *  is Gabriel (no apex inside its diametral circle), else from the first of
+ *  its triangles; it is interior, not on the boundary of the shape, once
+ *  both of its triangles are in (never for hull edges).
+ *
+ *  These critical alphas are computed once, in one pass over the finished
+ *  subdivision, and sorted. The complex for any alpha is then a prefix of
+ *  the triangles, found by a binary search, and its boundary is a scan of
+ *  a prefix of the edges. */
+
+#ifndef __ALPHA_COMPLEX_H__
+#define __ALPHA_COMPLEX_H__
+
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include "DelaunaySubdivision.h"
+
+
+class AlphaComplex {
+public:
+	typedef boost::shared_ptr<AlphaComplex> Ptr;
+
+	/** Computes and sorts the critical alphas of the triangles and edges of
+	 *  SUB, which must be triangulated already. Uses computeVoronoi for the
+	 *  circumcenters. */
+	AlphaComplex(DelaunaySubdivision *sub, bool time=false);
+
+	/** Number of triangles in the complex for ALPHA : they are the first
+	 *  ones of triangles(). */
+	int numTriangles(double alpha) const;
+
+	/** Appends to TRIS the vertices (3 per triangle, ccw) of the triangles
+	 *  of the complex for ALPHA. */
+	void triangles(double alpha, std::vector<int> &tris) const;
+
+	/** Appends to EDGES the end points (2 per edge) of the boundary of the
+	 *  alpha shape : the edges of the complex with at most one of their
+	 *  triangles in it. The shape is to the left of the regular edges (those
+	 *  with one triangle in); the singular ones (with none) are last when
+	 *  SINGULAR is set, else they are left out. Returns the number of
+	 *  regular edges. */
+	int boundary(double alpha, std::vector<int> &edges, bool singular=true) const;
+
+	/** The smallest alpha for which the complex is the whole triangulation. */
+	double maxAlpha() const;
+
+	// sorted by alpha : the vertices of the triangles (3 each, ccw)
+	// and their squared circumradii.
+	std::vector<int>    tri_verts;
+	std::vector<double> tri_alpha;
+
+	// sorted by edge_lo : the end points of the edges (2 each, the first
+	// triangle to enter the complex on the left), the alpha from which each
+	// is in the complex, the alpha of its left triangle (from which it is
+	// regular) and the alpha from which it is interior. Missing triangles
+	// have an infinite alpha.
+	std::vector<int>    edge_verts;
+	std::vector<double> edge_lo, edge_mid, edge_hi;
+};
+
+#endif
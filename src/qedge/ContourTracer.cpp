@@ -0,0 +1,150 @@
+/** Contour lines by marching triangles.
+ *  See ContourTracer.h */
+
+#include "ContourTracer.h"
+#include "utils/misc.h"
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <algorithm>
+#include <iostream>
+
+using namespace Eigen;
+using namespace std;
+
+
+/** Checks that SUB is triangulated. */
+ContourTracer::ContourTracer(DelaunaySubdivision *_sub, int _channel)
+	: sub(_sub), channel(_channel) {
+	if (!sub->randEdge) {
+		cout << "Contours : compute the triangulation first. Exiting.\n";
+		exit(-1);
+	}
+}
+
+
+/** Where the level L crosses the edge A-B of the values Z : OUT[0], OUT[1].
+ *  From the smaller index, so that both triangles of the edge agree. */
+static inline void levelCrossing(int a, int b, const vector<Vector2dPtr> &pts, const vector<double> &z,
+		double L, double *out) {
+	if (b < a) std::swap(a, b);
+	const double t = (L - z[a]) / (z[b] - z[a]);
+	const Vector2d &pa = *pts[a], &pb = *pts[b];
+	out[0] = pa.x() + t*(pb.x() - pa.x());
+	out[1] = pa.y() + t*(pb.y() - pa.y());
+}
+
+
+/** Thread entry for contours : the levels L with zmin < L <= zmax cross
+ *  the triangles [start, end). */
+void ContourTracer::contourCount(ContourSweep *S, int start, int end) {
+	for (int t = start; t < end; t += 1) {
+		const int *tri = &S->tris[3*t];
+		const double z0 = S->z[tri[0]], z1 = S->z[tri[1]], z2 = S->z[tri[2]];
+		const double zmin = std::min(z0, std::min(z1, z2)), zmax = std::max(z0, std::max(z1, z2));
+		const int lo = upper_bound(S->levels.begin(), S->levels.end(), zmin) - S->levels.begin();
+		const int hi = upper_bound(S->levels.begin() + lo, S->levels.end(), zmax) - S->levels.begin();
+		S->first[t] = lo;
+		S->offsets[t+1] = hi - lo;
+	}
+}
+
+
+/** Thread entry for contours : the segment of each level in the triangles
+ *  [start, end) enters across the edge going down (above to below, ccw)
+ *  and leaves across the edge going up, which keeps the values above the
+ *  level on its left; the triangle across that edge has the next one. */
+void ContourTracer::contourLink(ContourSweep *S, int start, int end) {
+	const vector<Vector2dPtr> &point_ptrs = sub->point_ptrs;
+	for (int t = start; t < end; t += 1) {
+		const int *tri = &S->tris[3*t];
+		for (int s = S->offsets[t], li = S->first[t]; s < S->offsets[t+1]; s += 1, li += 1) {
+			const double L = S->levels[li];
+			bool above[3];
+			for (int k = 0; k < 3; k += 1) above[k] = S->z[tri[k]] >= L;
+			int in = 0, out = 0;
+			for (int k = 0; k < 3; k += 1) {
+				if ( above[k] && !above[(k+1)%3]) in  = k;
+				if (!above[k] &&  above[(k+1)%3]) out = k;
+			}
+			const int n = S->nbrs[3*t+out];
+			S->next[s]     = (n >= 0)? S->offsets[n] + li - S->first[n] : -1;
+			S->has_prev[s] = S->nbrs[3*t+in] >= 0;
+			S->level[s]    = li;
+			levelCrossing(tri[in],  tri[(in+1)%3],  point_ptrs, S->z, L, &S->points[4*s]);
+			levelCrossing(tri[out], tri[(out+1)%3], point_ptrs, S->z, L, &S->points[4*s+2]);
+		}
+	}
+}
+
+
+/** Marching triangles over all the levels at once : count the crossings,
+ *  number them, link them, then walk the chains. */
+void ContourTracer::contours(const std::vector<double> &levels, Contours &lines, bool time) {
+	const ColMatrixXd &attributes = sub->attributes;
+	lines.levels = levels;
+	sort(lines.levels.begin(), lines.levels.end());
+	lines.levels.erase(unique(lines.levels.begin(), lines.levels.end()), lines.levels.end());
+	lines.level.clear(); lines.coords.clear();
+	lines.offsets.assign(1, 0);
+	if (channel < 0 || channel >= attributes.cols() || attributes.rows() < sub->point_ptrs.size()) {
+		cout << ">>> The sites have no attribute "<<channel<<" to contour. Skipping.\n";
+		return;
+	}
+	double tim = wallTime();
+	ContourSweep S;
+	S.z.resize(attributes.rows());
+	for (int i = 0; i < S.z.size(); i += 1) S.z[i] = attributes(i, channel);
+	S.levels = lines.levels;
+	sub->triangleMesh(S.tris, S.nbrs);
+	const int F = S.tris.size() / 3;
+	const double tim_freeze = wallTime() - tim;
+
+	tim = wallTime();
+	const int T = std::max(1, std::min(sub->num_threads, F/4096));
+	S.first.resize(F);
+	S.offsets.assign(F+1, 0);
+	{
+		boost::thread_group workers;
+		for (int t = 1; t < T; t += 1)
+			workers.create_thread(boost::bind(&ContourTracer::contourCount, this,
+					&S, (int) ((long) F*t/T), (int) ((long) F*(t+1)/T)));
+		contourCount(&S, 0, F/T);
+		workers.join_all();
+	}
+	for (int t = 0; t < F; t += 1) S.offsets[t+1] += S.offsets[t];
+	const int N = S.offsets[F];
+	S.next.resize(N); S.has_prev.resize(N); S.level.resize(N); S.points.resize(4*N);
+	{
+		boost::thread_group workers;
+		for (int t = 1; t < T; t += 1)
+			workers.create_thread(boost::bind(&ContourTracer::contourLink, this,
+					&S, (int) ((long) F*t/T), (int) ((long) F*(t+1)/T)));
+		contourLink(&S, 0, F/T);
+		workers.join_all();
+	}
+	const double tim_link = wallTime() - tim;
+
+	// the open lines first, from their slot on the hull, then the loops.
+	tim = wallTime();
+	vector<char> done(N, 0);
+	lines.coords.reserve(2*N + 2*F/8);
+	for (int pass = 0; pass < 2; pass += 1) {
+		for (int s = 0; s < N; s += 1) {
+			if (done[s] || (pass == 0 && S.has_prev[s])) continue;
+			lines.level.push_back(S.level[s]);
+			lines.coords.push_back(S.points[4*s]);
+			lines.coords.push_back(S.points[4*s+1]);
+			for (int c = s; c >= 0 && !done[c]; c = S.next[c]) {
+				done[c] = 1;
+				lines.coords.push_back(S.points[4*c+2]);
+				lines.coords.push_back(S.points[4*c+3]);
+			}
+			lines.offsets.push_back(lines.coords.size() / 2);
+		}
+	}
+	if (time) {
+		cout <<">>> contours : "<<tim_freeze<<" seconds to freeze "<<F<<" triangles, "<<tim_link
+			 <<" seconds to find and link "<<N<<" segments on "<<T<<" threads, "<<wallTime()-tim
+			 <<" seconds to walk them into "<<lines.level.size()<<" polylines ("<<lines.levels.size()<<" levels).\n";
+	}
+}
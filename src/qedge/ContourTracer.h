@@ -0,0 +1,75 @@
+/** Contour lines of a vertex attribute of a Delaunay triangulation, by
+ *  marching triangles.
+ *
+ *  All the levels are found in one sweep over the triangles, in parallel
+ *  on num_threads threads. Each level that crosses a triangle gives a
+ *  segment, linked to the next one through the triangle across its exit
+ *  edge; the chains are then walked into polylines. A value equal to a
+ *  level counts as above it, and each edge crossing is worked out from its
+ *  end points in a fixed order, so that the two triangles of an edge agree
+ *  on it. O(number of triangles + segments). */
+
+#ifndef __CONTOUR_TRACER_H__
+#define __CONTOUR_TRACER_H__
+
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include "DelaunaySubdivision.h"
+
+
+/** Contour lines as flat arrays : polyline k is at the level
+ *  LEVELS[LEVEL[k]] and has the points (COORDS[2j], COORDS[2j+1]) for j in
+ *  [OFFSETS[k], OFFSETS[k+1]). The values above the level are on its left.
+ *  It is closed if its last point is its first, else it ends on the hull. */
+struct Contours {
+	std::vector<double> levels;
+	std::vector<int>    level;
+	std::vector<int>    offsets;
+	std::vector<double> coords;
+};
+
+
+/** The state of ContourTracer::contours, shared by its threads. The
+ *  triangles are frozen with their neighbours, and each (triangle, level)
+ *  crossing gets a slot : those of triangle t are OFFSETS[t] ..
+ *  OFFSETS[t+1]-1, for its levels from FIRST[t] up. */
+struct ContourSweep {
+	std::vector<double> z;        // the value at each site
+	std::vector<double> levels;   // sorted
+	std::vector<int> tris;        // 3 ccw vertices per triangle
+	std::vector<int> nbrs;        // the triangle across (v_k, v_k+1), or -1
+	std::vector<int> first, offsets;
+	// per slot : the slot it leads to (-1 at the hull), whether one leads to
+	// it, its level, and where the line enters and leaves the triangle.
+	std::vector<int>    next;
+	std::vector<char>   has_prev;
+	std::vector<int>    level;
+	std::vector<double> points;   // 4 per slot : entry (x, y), exit (x, y)
+};
+
+
+class ContourTracer {
+public:
+	typedef boost::shared_ptr<ContourTracer> Ptr;
+
+	/** Traces the attribute CHANNEL of SUB, which must be triangulated
+	 *  already. */
+	ContourTracer(DelaunaySubdivision *sub, int channel=0);
+
+	/** Fills LINES with the contour lines at LEVELS (sorted, without
+	 *  repeats, into LINES.levels). No lines if the sites have no such
+	 *  attribute. With TIME, the time of each stage is printed. */
+	void contours(const std::vector<double> &levels, Contours &lines, bool time=false);
+
+private:
+	DelaunaySubdivision *sub;
+	int channel;
+
+	/** Thread entries for contours : count the crossings of the triangles
+	 *  [start, end) of S (FIRST, and the counts in OFFSETS[t+1]), then, once
+	 *  the slots are numbered, link them and place their points. */
+	void contourCount(ContourSweep *S, int start, int end);
+	void contourLink(ContourSweep *S, int start, int end);
+};
+
+#endif
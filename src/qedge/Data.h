@@ -15,6 +15,11 @@
 typedef boost::shared_ptr<Eigen::Vector2d> Vector2dPtr;
 typedef boost::shared_ptr<Eigen::Vector2f> Vector2fPtr;
 
+// Matrices with their storage order spelled out : the build makes Eigen
+// default to row major (EIGEN_DEFAULT_TO_ROW_MAJOR).
+typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::ColMajor> ColMatrixXd;
+typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> RowMatrixXd;
+
 
 
 class Data {
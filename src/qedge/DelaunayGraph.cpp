@@ -0,0 +1,56 @@
+/** The Delaunay graph as CSR.
+ *  See DelaunayGraph.h */
+
+#include "DelaunayGraph.h"
+#include "utils/misc.h"
+#include <iostream>
+
+using namespace std;
+
+
+/** Walks the Onext ring of every vertex twice : to count, then to fill. */
+CSRGraph::CSRGraph(DelaunaySubdivision *sub, bool time) {
+	if (!sub->randEdge) {
+		cout << "Delaunay graph : compute the triangulation first. Exiting.\n";
+		exit(-1);
+	}
+	double tim = wallTime();
+	sub->indexSites();
+	const vector<Edge::Ptr> &site_edges = sub->site_edges;
+	const int n = sub->point_ptrs.size();
+	const double tim_index = wallTime() - tim;
+
+	tim = wallTime();
+	offsets.assign(n+1, 0);
+	for (int v = 0; v < n; v += 1) {
+		Edge::Ptr e = site_edges[v];
+		if (!e) continue;
+		int degree = 0;
+		Edge::Ptr f = e;
+		do {
+			degree += 1;
+			f = f->Onext();
+		} while (f != e);
+		offsets[v+1] = degree;
+	}
+	for (int v = 0; v < n; v += 1)
+		offsets[v+1] += offsets[v];
+	const double tim_count = wallTime() - tim;
+
+	tim = wallTime();
+	targets.resize(offsets[n]);
+	for (int v = 0; v < n; v += 1) {
+		Edge::Ptr e = site_edges[v];
+		if (!e) continue;
+		int j = offsets[v];
+		Edge::Ptr f = e;
+		do {
+			targets[j++] = f->dest();
+			f = f->Onext();
+		} while (f != e);
+	}
+	if (time) {
+		cout <<">>> Delaunay graph : "<<tim_index<<" seconds to index the sites, "<<tim_count
+			 <<" seconds to count and "<<wallTime()-tim<<" seconds to fill "<<numEdges()<<" edges.\n";
+	}
+}
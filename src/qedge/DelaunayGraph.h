@@ -0,0 +1,30 @@
+/** The Delaunay graph of a triangulation as compressed sparse rows, for
+ *  graph analytics downstream : flat offsets and targets, with each edge
+ *  in both directions. Also the output of ProximityGraph. */
+
+#ifndef __DELAUNAY_GRAPH_H__
+#define __DELAUNAY_GRAPH_H__
+
+#include <vector>
+#include "DelaunaySubdivision.h"
+
+
+/** A graph on the sites, as compressed sparse rows : the neighbours of
+ *  the site v are targets[offsets[v]] .. targets[offsets[v+1]-1]. Each
+ *  edge is there in both directions. */
+struct CSRGraph {
+	std::vector<int> offsets; // size : number of sites + 1
+	std::vector<int> targets;
+
+	CSRGraph() {}
+
+	/** The Delaunay graph of SUB, which must be triangulated already : the
+	 *  neighbours of each site, counterclockwise, by two walks of its Onext
+	 *  ring (degree count, then fill). Sites which are not vertices
+	 *  (duplicates) have none. With TIME, the time of each walk is printed. */
+	explicit CSRGraph(DelaunaySubdivision *sub, bool time=false);
+
+	int numEdges() const { return targets.size() / 2; }
+};
+
+#endif
@@ -0,0 +1,146 @@
+/** Devillers' [2002] Delaunay hierarchy for fast point location.
+ *  See DelaunayHierarchy.h */
+
+#include "DelaunayHierarchy.h"
+#include <iostream>
+
+using namespace Eigen;
+using namespace std;
+
+
+/** Builds the levels above BASE, which must be triangulated already.*/
+DelaunayHierarchy::DelaunayHierarchy(DelaunaySubdivision *_base, CutsType t)
+	: base(_base), cuts(t), rng(274) {
+	if (!base->randEdge) {
+		cout << "Delaunay hierarchy : compute the triangulation first. Exiting.\n";
+		exit(-1);
+	}
+	base->indexSites();
+	while (addLevel());
+}
+
+
+/** Samples the top level and triangulates the sample as a new top level.*/
+bool DelaunayHierarchy::addLevel() {
+	DelaunaySubdivision *top = level(numLevels()-1);
+
+	// duplicates are not vertices : they are not sampled.
+	vector<int> sample;
+	for (int i = 0; i < top->points.size(); i += 1) {
+		const int v = top->points[i];
+		if (top->point_ptrs[v] && top->siteEdge(v) && rng() % RATIO == 0)
+			sample.push_back(v);
+	}
+	if (sample.size() < MIN_LEVEL_SIZE) return false;
+
+	DelaunaySubdivision::Ptr lvl(new DelaunaySubdivision(sample, top->point_ptrs));
+	lvl->computeDelaunay(cuts);
+	lvl->indexSites();
+	upper.push_back(lvl);
+	upper_sizes.push_back(sample.size());
+	return true;
+}
+
+
+/** Frees the levels above the base. */
+DelaunayHierarchy::~DelaunayHierarchy() {
+	for (int k = 0; k < upper.size(); k += 1)
+		upper[k]->clearSubdivision();
+}
+
+
+/** Number of levels, including the base. */
+int DelaunayHierarchy::numLevels() const {
+	return upper.size() + 1;
+}
+
+
+DelaunaySubdivision *DelaunayHierarchy::level(int k) {
+	return (k == 0)? base : upper[k-1].get();
+}
+
+
+/** Walks every level from the top down to level 0.
+ *  A level is entered at the vertex, of the triangle found at the level
+ *  above, which is the nearest to X. The top level, or a level whose
+ *  link has gone stale, is entered by jump-and-walk. */
+void DelaunayHierarchy::descend(const Eigen::Vector2d &x, std::vector<Edge::Ptr> &found) {
+	const int L = numLevels();
+	found.assign(L, Edge::Ptr());
+
+	int nearest = -1;
+	for (int k = L-1; k >= 0; k -= 1) {
+		DelaunaySubdivision *lvl = level(k);
+		if (lvl->site_edges.size() != lvl->point_ptrs.size()) lvl->indexSites();
+
+		Edge::Ptr start;
+		if (nearest >= 0 && nearest < lvl->site_edges.size()) start = lvl->siteEdge(nearest);
+		if (!start) start = lvl->nearbyEdge(x);
+
+		Edge::Ptr e = lvl->locate(x, start);
+		found[k] = e;
+
+		int cand[3] = {e->org(), e->dest(), e->Lprev()->org()};
+		const int C = lvl->leftFaceIsTriangle(e)? 3 : 2;
+		nearest = cand[0];
+		for (int c = 1; c < C; c += 1) {
+			if ((*lvl->point_ptrs[cand[c]] - x).squaredNorm() < (*lvl->point_ptrs[nearest] - x).squaredNorm())
+				nearest = cand[c];
+		}
+	}
+}
+
+
+/** Locates X : returns an edge of the base subdivision.*/
+Edge::Ptr DelaunayHierarchy::locate(const Eigen::Vector2d &x) {
+	vector<Edge::Ptr> found;
+	descend(x, found);
+	return found[0];
+}
+
+
+/** Inserts the new site (X, Y) into the base subdivision, and into
+ *  each level above with probability 1/RATIO of the level below.*/
+Edge::Ptr DelaunayHierarchy::insertSite(double x, double y) {
+	const Vector2d p(x, y);
+	vector<Edge::Ptr> found;
+	descend(p, found);
+
+	const int id = base->point_ptrs.size();
+	Vector2dPtr ptr(new Vector2d(p));
+	Edge::Ptr e = base->insertSiteIndex(id, ptr, found[0]);
+	if (e->org() != id) {
+		// a duplicate : give its index back.
+		base->point_ptrs.pop_back();
+		base->site_edges.pop_back();
+		return e;
+	}
+
+	// the walks above did not change : their edges are still valid hints.
+	int k = 1;
+	for (; k < numLevels() && rng() % RATIO == 0; k += 1) {
+		level(k)->insertSiteIndex(id, ptr, found[k]);
+		upper_sizes[k-1] += 1;
+	}
+	if (k == numLevels() && rng() % RATIO == 0) addLevel();
+	return e;
+}
+
+
+/** Removes the site ID from all the levels it is in. */
+bool DelaunayHierarchy::removeSite(int id) {
+	if (!base->removeSite(id)) return false;
+	for (int k = 1; k < numLevels(); k += 1) {
+		if (!level(k)->removeSite(id)) break;
+		upper_sizes[k-1] -= 1;
+		if (upper_sizes[k-1] < MIN_LEVEL_SIZE/2) {
+			// too small to be worth keeping : drop it and the levels above.
+			for (int j = k-1; j < upper.size(); j += 1)
+				upper[j]->clearSubdivision();
+			upper.resize(k-1);
+			upper_sizes.resize(k-1);
+			break;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,78 @@
+/** Devillers' [2002] Delaunay hierarchy for fast point location.
+ *
+ *  Level 0 is a finished DelaunaySubdivision. Level k+1 triangulates a
+ *  random 1/RATIO sample of the vertices of level k. A point is located
+ *  at the top level by a walk, and then each level is walked starting
+ *  from the vertex found nearest at the level above : the walks are
+ *  O(1) long on expectation, so a random query takes O(log n) time.
+ *
+ *  The vertex links between the levels are the site_edges indices of the
+ *  subdivisions : the same vertex has the same index at every level. */
+
+#ifndef __DELAUNAY_HIERARCHY_H__
+#define __DELAUNAY_HIERARCHY_H__
+
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include "DelaunaySubdivision.h"
+
+
+class DelaunayHierarchy {
+public:
+	typedef boost::shared_ptr<DelaunayHierarchy> Ptr;
+
+	// sampling ratio between consecutive levels.
+	static const int RATIO = 30;
+
+	// the levels above the base are not built below this size,
+	// and are dropped when removals take them below half of it.
+	static const int MIN_LEVEL_SIZE = 64;
+
+	/** Builds the levels above BASE, which must be triangulated already.
+	 *  The levels are triangulated with the algorithm T.*/
+	DelaunayHierarchy(DelaunaySubdivision *base, CutsType t=ALTERNATE_CUTS);
+
+	/** Frees the levels above the base. */
+	~DelaunayHierarchy();
+
+	/** Locates X : returns an edge of the base subdivision,
+	 *  as DelaunaySubdivision::locate does. */
+	Edge::Ptr locate(const Eigen::Vector2d &x);
+
+	/** Inserts the new site (X, Y) into the base subdivision, and into
+	 *  each level above with probability 1/RATIO of the level below.
+	 *  A new top level is added when a site is promoted past the top one.
+	 *  Returns the edge given by DelaunaySubdivision::insertSite. */
+	Edge::Ptr insertSite(double x, double y);
+
+	/** Removes the site ID from all the levels it is in.
+	 *  Returns false if it is not a vertex of the base subdivision. */
+	bool removeSite(int id);
+
+	/** Number of levels, including the base. */
+	int numLevels() const;
+
+private:
+	// levels[0] is the base : not owned.
+	DelaunaySubdivision *base;
+	std::vector<DelaunaySubdivision::Ptr> upper;
+	std::vector<int> upper_sizes;
+
+	// algorithm which triangulates the levels.
+	CutsType cuts;
+
+	boost::mt19937 rng;
+
+	DelaunaySubdivision *level(int k);
+
+	/** Samples the top level and triangulates the sample as a new top level.
+	 *  Returns false if the sample is below MIN_LEVEL_SIZE. */
+	bool addLevel();
+
+	/** Walks every level from the top down to level 0, and stores
+	 *  the edge found at level k in FOUND[k].*/
+	void descend(const Eigen::Vector2d &x, std::vector<Edge::Ptr> &found);
+};
+
+#endif
@@ -7,6 +7,16 @@
 #include "io_utils.h"
 #include "utils/sorting.h"
 #include <time.h>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/unordered_set.hpp>
+#include <cmath>
+#include <queue>
+#include <sstream>
+#include <cstdio>
+#include <unistd.h>
+#include <sys/wait.h>
 
 using namespace Eigen;
 using namespace std;
@@ -17,10 +27,13 @@ bool  DelaunaySubdivision::CCW(int a, int b, int c) {
 	return ret;
 }
 
-/** Wrapper for incircle (orient2d) function.*/
+/** Wrapper for incircle (orient2d) function : the power test
+ *  instead, once computeRegular has set the weights.*/
 bool DelaunaySubdivision::INCIRCLE(int a, int b, int c, int d) {
-	double val =  incircle(*(point_ptrs[a]), *(point_ptrs[b]),
-			                *(point_ptrs[c]), *(point_ptrs[d]));
+	double val = weights.empty()?
+			incircle(*(point_ptrs[a]), *(point_ptrs[b]), *(point_ptrs[c]), *(point_ptrs[d]))
+			: powertest(*(point_ptrs[a]), *(point_ptrs[b]), *(point_ptrs[c]), *(point_ptrs[d]),
+			            weights[a], weights[b], weights[c], weights[d]);
 	bool ret =  val > 0.0;
 	return ret;
 }
@@ -41,16 +54,30 @@ bool DelaunaySubdivision::valid (Edge::Ptr e, Edge::Ptr basel) {
 	return rightOf(e->dest(), basel);
 }
 
+/** Constructor : triangulates the sites IDS of PTRS.
+ *  Only the pointers of IDS are copied; the points themselves are shared. */
+DelaunaySubdivision::DelaunaySubdivision(const std::vector<int> &ids,
+		const std::vector<Vector2dPtr> &ptrs, string outname)
+	: out_prefix(outname), points(ids), point_ptrs(ptrs.size()), num_qedges(0), rng(274) {
+	num_threads = std::max(1u, boost::thread::hardware_concurrency());
+	for (int i = 0; i < ids.size(); i += 1)
+		point_ptrs[ids[i]] = ptrs[ids[i]];
+}
+
 /** Constructor. */
-DelaunaySubdivision::DelaunaySubdivision(string fname, string outname) : num_qedges(0),points() {
-	if (fname.substr(fname.length()-5,5)!= ".node") {
-		cout << "Expecting input file with .node extension. Instead, found "
-				<<fname.substr(fname.length()-5,5)<<". Exiting.\n";
+DelaunaySubdivision::DelaunaySubdivision(string fname, string outname) : num_qedges(0),points(),rng(274) {
+	num_threads = std::max(1u, boost::thread::hardware_concurrency());
+
+	const string ext = (fname.length() < 5)? fname : fname.substr(fname.length()-5,5);
+	if (ext != ".node" && ext != ".poly") {
+		cout << "Expecting input file with .node or .poly extension. Instead, found "
+				<<ext<<". Exiting.\n";
 		exit(-1);
 	}
 
 	out_prefix  = (outname =="xdefaultx")? fname.substr(0, fname.length()-5) : outname;
-	readNodeFile(fname, points, point_ptrs);
+	if (ext == ".node") readNodeFile(fname, points, point_ptrs, &attributes);
+	else                readPolyFile(fname, points, point_ptrs, segments, &attributes);
 }
 
 /** Adds a new edge connecting the destination of e1 to the origin of e2.
@@ -70,6 +97,16 @@ Edge::Ptr DelaunaySubdivision::connect(Edge::Ptr e1, Edge::Ptr e2) {
 
 /** Removes the edge E from the subdivision. From G&S [pg. 103]. */
 void DelaunaySubdivision::deleteEdge(Edge::Ptr e) {
+	// keep the site index on edges which stay.
+	if (!site_edges.empty()) {
+		Edge::Ptr ends[2] = {e, e->Sym()};
+		for (int k = 0; k < 2; k += 1) {
+			const int v = ends[k]->org();
+			if (v < site_edges.size() && site_edges[v] && site_edges[v]->qEdge() == e->qEdge())
+				site_edges[v] = (ends[k]->Onext() != ends[k])? ends[k]->Onext() : Edge::Ptr();
+		}
+	}
+
 	Edge::splice(e, e->Oprev());
 	Edge::splice(e->Sym(), e->Sym()->Oprev());
 
@@ -80,10 +117,17 @@ void DelaunaySubdivision::deleteEdge(Edge::Ptr e) {
 }
 
 /** Flips the diagonal of the quadrilateral containing e. From G&S [pg. 104]. */
-void DelaunaySubdivision::swap(Edge::Ptr e) {
+bool DelaunaySubdivision::swap(Edge::Ptr e) {
+	if (e->qEdge()->constrained) return false;
 	Edge::Ptr a = e->Oprev();
 	Edge::Ptr b = e->Sym()->Oprev();
 
+	// the ends of E lose it : keep the site index on A and B.
+	if (!site_edges.empty()) {
+		if (e->org()  < site_edges.size()) site_edges[e->org()]  = a;
+		if (e->dest() < site_edges.size()) site_edges[e->dest()] = b;
+	}
+
 	// disconnect the edge
 	Edge::splice(e, a);           Edge::splice(e->Sym(), b);
 
@@ -93,6 +137,7 @@ void DelaunaySubdivision::swap(Edge::Ptr e) {
 	// update coordinates
 	e->setOrg(a->dest());
 	e->setDest(b->dest());
+	return true;
 }
 
 
@@ -184,8 +229,10 @@ DelaunaySubdivision::divideConquerVerticalCuts(int start, int end) {
  *  PTS   : vector of points. it is assumed that PTS.size() > 1
  *  start : the start index of PTS
  *  end   : the end index   of PTS
- *  axis  : the axis along which the point-set needs to be cut. */
-std::pair<Edge::Ptr, Edge::Ptr>
+ *  axis  : the axis along which the point-set needs to be cut.
+ *
+ *  Returns all the four extreme hull edges of the triangulation. */
+HullHandles
 DelaunaySubdivision::divideConquerAlternatingCuts(int start, int end, int axis) {
 	const int SIZE = end-start+1;
 	checkRange(start, end);
@@ -194,22 +241,602 @@ DelaunaySubdivision::divideConquerAlternatingCuts(int start, int end, int axis)
 		// sort lexico-graphically for further processing.
 		// this takes constant time, as the size is constant.
 		lexicoSort(points, &point_ptrs, start, end);
-		return doBaseCases(start, end);
+		return hullHandles(doBaseCases(start, end));
 	} else {
 		// make recursive calls. Split the points into left and right
 		const int mid = median(points, &point_ptrs, start, end, axis);
 
-		pair<Edge::Ptr, Edge::Ptr> first_handles  = divideConquerAlternatingCuts(start, mid, mod(axis+1,2));
-		pair<Edge::Ptr, Edge::Ptr> second_handles = divideConquerAlternatingCuts(mid+1, end, mod(axis+1,2));
+		HullHandles first_handles  = divideConquerAlternatingCuts(start, mid, mod(axis+1,2));
+		HullHandles second_handles = divideConquerAlternatingCuts(mid+1, end, mod(axis+1,2));
+
+		return mergeHulls(first_handles, second_handles, axis);
+	}
+}
+
+
+/** Shared state of the seam-first triangulation (dewallDelaunay). The
+ *  sites are used by rank, their index in the sorted order. All but the
+ *  rings are read-only while the threads run; the ring of a site (and its
+ *  edges) is only touched by the thread which owns its range of ranks. */
+struct WallState {
+	vector<int>       sites;     // the distinct sites, lexico-sorted.
+	vector<int>       rank;      // rank of each site index; -1 if left out.
+	vector<Vector2d>  xy;        // coordinates, by rank.
+	vector<int>       hull;      // ccw hull, with the sites on its edges.
+	vector<int>       hull_next; // next rank along the hull, -1 inside.
+	vector<Edge::Ptr> ring;      // an edge out of each rank.
+
+	// a G x G grid of buckets over the bounding box.
+	int G;
+	Vector2d lo, scale;
+	vector<int> cell_start, cell_sites;
+
+	void cellOf(const Vector2d &p, int &gx, int &gy) const {
+		gx = (int) std::max(0.0, std::min(G-1.0, floor((p.x()-lo.x()) * scale.x())));
+		gy = (int) std::max(0.0, std::min(G-1.0, floor((p.y()-lo.y()) * scale.y())));
+	}
+};
+
+
+/** Is the rank D inside the circle through the ranks A, B, C (ccw)? On a
+ *  tie the site of the smallest rank is lifted a little off the paraboloid,
+ *  so that seams and halves built apart cut a cocircular polygon into the
+ *  same triangles. */
+static bool inCircleLifted(const WallState &w, int a, int b, int c, int d) {
+	const double v = incircle(w.xy[a], w.xy[b], w.xy[c], w.xy[d]);
+	if (v != 0.0) return v > 0.0;
+	const int m = std::min(std::min(a, b), std::min(c, d));
+	if (m == d) return false;
+	if (m == a) return orient2d(w.xy[b], w.xy[c], w.xy[d]) > 0.0;
+	if (m == b) return orient2d(w.xy[c], w.xy[a], w.xy[d]) > 0.0;
+	return orient2d(w.xy[a], w.xy[b], w.xy[d]) > 0.0;
+}
+
+
+/** Tests the sites of the grid cell (GX, GY) against BEST, the site left
+ *  of A -> B with the smallest circle so far. */
+static void scanCell(const WallState &w, int gx, int gy, int a, int b, int &best) {
+	if (gx < 0 || gy < 0 || gx >= w.G || gy >= w.G) return;
+	const int cell = gx*w.G + gy;
+	for (int i = w.cell_start[cell]; i < w.cell_start[cell+1]; i += 1) {
+		const int q = w.cell_sites[i];
+		if (q == a || q == b || orient2d(w.xy[a], w.xy[b], w.xy[q]) <= 0.0) continue;
+		if (best < 0 || inCircleLifted(w, a, b, best, q)) best = q;
+	}
+}
+
+
+/** The rank C left of A -> B whose circle through A, B and C holds no
+ *  other site : the Delaunay triangle left of the edge A -> B. -1 if the
+ *  edge is on the hull, with the outer face on its left. The cells are
+ *  searched in square rings around the middle of the edge till a site is
+ *  found, then in the bounding box of its circle. */
+static int delaunaySite(const WallState &w, int a, int b) {
+	if (w.hull_next[b] == a) return -1;
+	const Vector2d &pa = w.xy[a], &pb = w.xy[b];
+	int cx, cy;
+	w.cellOf(0.5*(pa + pb), cx, cy);
+
+	int best = -1, k = 0;
+	for (; best < 0 && k < w.G; k += 1) {
+		if (k == 0) {
+			scanCell(w, cx, cy, a, b, best);
+			continue;
+		}
+		for (int d = -k; d <= k; d += 1) {
+			scanCell(w, cx+d, cy-k, a, b, best);
+			scanCell(w, cx+d, cy+k, a, b, best);
+		}
+		for (int d = 1-k; d < k; d += 1) {
+			scanCell(w, cx-k, cy+d, a, b, best);
+			scanCell(w, cx+k, cy+d, a, b, best);
+		}
+	}
+	if (best < 0) return -1;
+	const int done = k-1; // the rings searched so far.
+
+	// the part of a smaller circle through A and B left of the edge lies
+	// in this one : the cells it misses can be skipped. A flat triangle
+	// has no reliable circle : search everything.
+	const Vector2d &pc = w.xy[best];
+	const double area = orient2d(pa, pb, pc);
+	const Vector2d o = circumcenter(pa, pb, pc);
+	const double r = (pa - o).norm() * (1.0 + 1e-6);
+	int x0 = 0, x1 = w.G-1, y0 = 0, y1 = w.G-1;
+	const bool bounded = r < HUGE_VAL && area > 1e-10 * (pb-pa).norm() * (pc-pa).norm();
+	if (bounded) {
+		w.cellOf(o - Vector2d(r, r), x0, y0);
+		w.cellOf(o + Vector2d(r, r), x1, y1);
+	}
+	for (int gx = x0; gx <= x1; gx += 1) {
+		for (int gy = y0; gy <= y1; gy += 1) {
+			if (std::max(abs(gx-cx), abs(gy-cy)) <= done) continue;
+			if (bounded) {
+				// distance from the centre to the cell.
+				const double lx = w.lo.x() + gx / w.scale.x(), ly = w.lo.y() + gy / w.scale.y();
+				const double dx = std::max(0.0, std::max(lx - o.x(), o.x() - (lx + 1.0/w.scale.x())));
+				const double dy = std::max(0.0, std::max(ly - o.y(), o.y() - (ly + 1.0/w.scale.y())));
+				if (dx*dx + dy*dy > r*r) continue;
+			}
+			scanCell(w, gx, gy, a, b, best);
+		}
+	}
+	return best;
+}
+
+
+/** The edge from the rank U to the rank V, or a null edge. */
+static Edge::Ptr findEdge(const WallState &w, int u, int v) {
+	Edge::Ptr e = w.ring[u];
+	if (!e) return e;
+	Edge::Ptr f = e;
+	do {
+		if (f->dest() == w.sites[v]) return f;
+		f = f->Onext();
+	} while (f != e);
+	return Edge::Ptr();
+}
+
+
+/** Splices the new edge E into the ring of its origin, in the gap between
+ *  two edges where its direction lies. */
+static void attach(WallState &w, Edge::Ptr e) {
+	const int v = w.rank[e->org()];
+	if (!w.ring[v]) {
+		w.ring[v] = e;
+		return;
+	}
+	const Vector2d &o = w.xy[v], &d = w.xy[w.rank[e->dest()]];
+	Edge::Ptr x = w.ring[v];
+	while (x->Onext() != x) {
+		Edge::Ptr y = x->Onext();
+		const Vector2d &u = w.xy[w.rank[x->dest()]], &t = w.xy[w.rank[y->dest()]];
+		const bool l = orient2d(o, u, d) > 0.0, r = orient2d(o, d, t) > 0.0;
+		if (orient2d(o, u, t) > 0.0? (l && r) : (l || r)) break;
+		x = y;
+		if (x == w.ring[v]) {
+			cout << "Seam-first triangulation : no room for an edge at site "<<e->org()<<". Exiting.\n";
+			exit(-1);
+		}
+	}
+	Edge::splice(e, x);
+}
+
+
+/** Makes the hull edge U -> V (interior on its left) if it is not there
+ *  yet, with its left face to be built. Returns it, or a null edge. */
+static Edge::Ptr seedHullEdge(WallState &w, int u, int v) {
+	if (findEdge(w, u, v)) return Edge::Ptr();
+	Edge::Ptr e = QuadEdge::makeEdge();
+	e->setOrg(w.sites[u]);
+	e->setDest(w.sites[v]);
+	attach(w, e);
+	attach(w, e->Sym());
+	e->visit_num = 1;
+	return e;
+}
+
+
+/** Closes the face left of the edge E (a -> b) with the triangle a, b, c,
+ *  C a rank, making the edges it lacks. The edges whose other side is
+ *  still to be built are put on MADE. Edge::visit_num marks these sides.*/
+static void closeTriangle(WallState &w, Edge::Ptr e, int c, vector<Edge::Ptr> &made) {
+	const int site = w.sites[c];
+	// b -> c follows e around the face, and a -> c comes after it at a.
+	Edge::Ptr bc = e->Lnext(), ca = e->Onext()->Sym();
+	const bool has_bc = (bc->dest() == site), has_ca = (ca->org() == site);
+
+	if (!has_bc) {
+		Edge::Ptr n = QuadEdge::makeEdge();
+		n->setOrg(e->dest());
+		n->setDest(site);
+		Edge::splice(n, e->Sym()->Oprev());
+		if (has_ca) Edge::splice(n->Sym(), ca);
+		else        attach(w, n->Sym());
+		n->Sym()->visit_num = 1;
+		made.push_back(n->Sym());
+		bc = n;
+	}
+	if (!has_ca) {
+		Edge::Ptr m = QuadEdge::makeEdge();
+		m->setOrg(e->org());
+		m->setDest(site);
+		Edge::splice(m, e);
+		Edge::splice(m->Sym(), bc->Sym()->Oprev());
+		m->visit_num = 1;
+		made.push_back(m);
+		ca = m->Sym();
+	}
+	e->visit_num = bc->visit_num = ca->visit_num = 0;
+}
+
+
+/** Builds the triangles left of the edges on TODO, and of the new edges
+ *  which cross the cut after the rank MID (all of them if MID < 0). The
+ *  other new edges are put on REST. The triangles must stay in the ranks
+ *  [LO, HI]. */
+static void buildTriangles(WallState &w, int lo, int hi, int mid,
+		vector<Edge::Ptr> &todo, vector<Edge::Ptr> &rest) {
+	vector<Edge::Ptr> made;
+	while (!todo.empty()) {
+		Edge::Ptr e = todo.back();
+		todo.pop_back();
+		if (!e->visit_num) continue;
+		const int c = delaunaySite(w, w.rank[e->org()], w.rank[e->dest()]);
+		if (c < 0) {
+			e->visit_num = 0; // a hull edge.
+			continue;
+		}
+		if (c < lo || c > hi) {
+			cout << "Seam-first triangulation : a triangle crosses a seam. Exiting.\n";
+			exit(-1);
+		}
+		made.clear();
+		closeTriangle(w, e, c, made);
+		for (int k = 0; k < made.size(); k += 1) {
+			const int u = w.rank[made[k]->org()], v = w.rank[made[k]->dest()];
+			if (mid < 0 || (u <= mid) != (v <= mid)) todo.push_back(made[k]);
+			else                                     rest.push_back(made[k]);
+		}
+	}
+}
+
+
+/** Triangulates the ranks [LO, HI] from the edges in ACTIVE, which have
+ *  both ends in the range and their left face to be built. The seam, the
+ *  triangles across the cut after the middle rank, is built first; it
+ *  leaves the two halves with no triangle in common, and they are then
+ *  triangulated apart, on two threads for the top DEPTH levels. */
+static void wallRange(WallState *w, int lo, int hi, int depth, vector<Edge::Ptr> *active) {
+	vector<Edge::Ptr> rest;
+	if (depth <= 0 || hi - lo < 1024) {
+		buildTriangles(*w, lo, hi, -1, *active, rest);
+		return;
+	}
+
+	// the seam grows from the edges across the cut which are built
+	// already, and from the hull edges across it.
+	const int mid = lo + (hi-lo)/2;
+	vector<Edge::Ptr> seam;
+	for (int i = 0; i < active->size(); i += 1) {
+		Edge::Ptr e = (*active)[i];
+		if ((w->rank[e->org()] <= mid) != (w->rank[e->dest()] <= mid)) seam.push_back(e);
+		else                                                          rest.push_back(e);
+	}
+	active->clear();
+	for (int i = 0; i < w->hull.size(); i += 1) {
+		const int u = w->hull[i], v = w->hull[(i+1) % w->hull.size()];
+		if (u < lo || u > hi || v < lo || v > hi || (u <= mid) == (v <= mid)) continue;
+		Edge::Ptr e = seedHullEdge(*w, u, v);
+		if (e) seam.push_back(e);
+	}
+	buildTriangles(*w, lo, hi, mid, seam, rest);
+
+	vector<Edge::Ptr> left, right;
+	for (int i = 0; i < rest.size(); i += 1) {
+		if (!rest[i]->visit_num) continue;
+		if (w->rank[rest[i]->org()] <= mid) left.push_back(rest[i]);
+		else                                right.push_back(rest[i]);
+	}
+	boost::thread worker(boost::bind(&wallRange, w, lo, mid, depth-1, &left));
+	wallRange(w, mid+1, hi, depth-1, &right);
+	worker.join();
+}
+
+
+/** Seam-first (DeWall) triangulation [Cignoni, Montani & Scopigno, 1998] :
+ *  see the header. Returns a ccw hull edge (outer face on its right) out
+ *  of the lexico-smallest site, or a null edge if the sites are collinear.*/
+Edge::Ptr DelaunaySubdivision::dewallDelaunay() {
+	lexicoSort(points, &point_ptrs, 0, points.size()-1);
+
+	// the distinct sites : a duplicate is left out.
+	WallState w;
+	w.rank.assign(point_ptrs.size(), -1);
+	for (int i = 0; i < points.size(); i += 1) {
+		const Vector2d &p = *point_ptrs[points[i]];
+		if (!w.xy.empty() && w.xy.back() == p) continue;
+		w.rank[points[i]] = w.sites.size();
+		w.sites.push_back(points[i]);
+		w.xy.push_back(p);
+	}
+	const int M = w.sites.size();
+	if (M < 3) return Edge::Ptr();
+
+	// the ccw hull (monotone chain), keeping the sites on its edges.
+	vector<int> lower, upper;
+	for (int r = 0; r < M; r += 1) {
+		while (lower.size() > 1 && orient2d(w.xy[lower[lower.size()-2]], w.xy[lower.back()], w.xy[r]) < 0.0)
+			lower.pop_back();
+		lower.push_back(r);
+	}
+	for (int r = M-1; r >= 0; r -= 1) {
+		while (upper.size() > 1 && orient2d(w.xy[upper[upper.size()-2]], w.xy[upper.back()], w.xy[r]) < 0.0)
+			upper.pop_back();
+		upper.push_back(r);
+	}
+	if (lower.size() == M) return Edge::Ptr(); // all on a line.
+	w.hull = lower;
+	w.hull.insert(w.hull.end(), upper.begin()+1, upper.end()-1);
+	w.hull_next.assign(M, -1);
+	for (int i = 0; i < w.hull.size(); i += 1)
+		w.hull_next[w.hull[i]] = w.hull[(i+1) % w.hull.size()];
+
+	// the grid, about 2 sites to a cell : counting sort.
+	w.G = std::max(1, (int) sqrt(M / 2.0));
+	w.lo = w.xy[0];
+	Vector2d hi = w.xy[0];
+	for (int r = 1; r < M; r += 1) {
+		w.lo = w.lo.cwiseMin(w.xy[r]);
+		hi   = hi.cwiseMax(w.xy[r]);
+	}
+	const Vector2d ext = (hi - w.lo).cwiseMax(Vector2d(1e-300, 1e-300));
+	w.scale = Vector2d(w.G / ext.x(), w.G / ext.y());
+	vector<int> cell(M);
+	w.cell_start.assign(w.G*w.G + 1, 0);
+	for (int r = 0; r < M; r += 1) {
+		int gx, gy;
+		w.cellOf(w.xy[r], gx, gy);
+		cell[r] = gx*w.G + gy;
+		w.cell_start[cell[r]+1] += 1;
+	}
+	for (int c = 0; c < w.G*w.G; c += 1)
+		w.cell_start[c+1] += w.cell_start[c];
+	w.cell_sites.resize(M);
+	vector<int> fill(w.cell_start.begin(), w.cell_start.end()-1);
+	for (int r = 0; r < M; r += 1)
+		w.cell_sites[fill[cell[r]]++] = r;
+	w.ring.resize(M);
+
+	// the lower hull edge across the first cut starts the first seam.
+	int depth = 0;
+	while ((1 << depth) < num_threads) depth += 1;
+	vector<Edge::Ptr> active;
+	for (int i = 0; i+1 < lower.size(); i += 1) {
+		if (lower[i] <= (M-1)/2 && lower[i+1] > (M-1)/2) {
+			active.push_back(seedHullEdge(w, lower[i], lower[i+1]));
+			break;
+		}
+	}
+	wallRange(&w, 0, M-1, depth, &active);
+	return findEdge(w, w.hull[0], w.hull[1]);
+}
+
+/** Given the boundaries of consecutive ranges of points, groups the
+ *  ranges so that each group has at least 2 points (a leftover is joined
+ *  with the last group). Returns the indices into BOUNDS of the group boundaries. */
+static vector<int> groupRanges(const vector<int> &bounds) {
+	vector<int> groups(1, 0);
+	for (int k = 1; k < bounds.size(); k += 1)
+		if (bounds[k] - bounds[groups.back()] >= 2)
+			groups.push_back(k);
+
+	if (groups.back() != bounds.size()-1) {
+		if (groups.size() > 1) groups.back() = bounds.size()-1;
+		else                   groups.push_back(bounds.size()-1);
+	}
+	return groups;
+}
+
+
+/** Dwyer's [1987] cell-bucketing variant of the divide-and-conquer.
+ *
+ *  ********** THIS FUNCTION DOES NOT ASSUME THAT THE POINTS ARE SORTED**********
+ *
+ *  The bounding box is cut into S = sqrt(n/log n) vertical strips, each
+ *  cut into S cells. A counting sort buckets the points by (strip, cell).
+ *  Cells are triangulated with vertical cuts, merged bottom-to-top within
+ *  each strip, and the strips are then merged left-to-right.
+ *
+ *  Cells (and strips) with fewer than 2 points are joined with their
+ *  neighbours; as the buckets are cut by coordinate, the joined sets stay
+ *  separated along the merge axis. Of equal points, the first site in
+ *  file order is kept; the others are left at the end of PTS.
+ *
+ *  Returns all the four extreme hull edges of the triangulation. */
+HullHandles DelaunaySubdivision::dwyerDelaunay() {
+	const int N = points.size();
+	checkRange(0, N-1);
+
+	const int S = std::max(1, (int) sqrt(N / std::max(1.0, log((double) N))));
+
+	Vector2d lo = *point_ptrs[points[0]], hi = lo;
+	for (int i = 1; i < N; i += 1) {
+		lo = lo.cwiseMin(*point_ptrs[points[i]]);
+		hi = hi.cwiseMax(*point_ptrs[points[i]]);
+	}
+	const Vector2d ext = (hi - lo).cwiseMax(Vector2d(1e-300, 1e-300));
+
+	// bucket the points by (strip, cell) : counting sort.
+	vector<int> bucket(N), count(S*S+1, 0);
+	for (int i = 0; i < N; i += 1) {
+		const Vector2d &p = *point_ptrs[points[i]];
+		const int sx = std::min(S-1, (int) ((p.x()-lo.x()) / ext.x() * S));
+		const int sy = std::min(S-1, (int) ((p.y()-lo.y()) / ext.y() * S));
+		bucket[i] = sx*S + sy;
+		count[bucket[i]+1] += 1;
+	}
+	for (int b = 0; b < S*S; b += 1)
+		count[b+1] += count[b];
+
+	vector<int> bucketed(N);
+	vector<int> fill(count.begin(), count.end()-1);
+	for (int i = 0; i < N; i += 1)
+		bucketed[fill[bucket[i]]++] = points[i];
+	points.swap(bucketed);
+
+	// duplicates share a cell : sort each one (triangulateRange does so
+	// anyway) and keep one site of each point, the others at the end.
+	vector<int> dropped;
+	int n = 0;
+	for (int b = 0; b < S*S; b += 1) {
+		const int from = count[b], to = count[b+1];
+		count[b] = n;
+		if (from == to) continue;
+		lexicoSort(points, &point_ptrs, from, to-1);
+		const int kept = dropDuplicates(from, to-1);
+		dropped.insert(dropped.end(), points.begin()+from+kept, points.begin()+to);
+		for (int i = 0; i < kept; i += 1)
+			points[n++] = points[from+i];
+	}
+	count[S*S] = n;
+	std::copy(dropped.begin(), dropped.end(), points.begin()+n);
+	checkRange(0, n-1);
+
+	vector<int> strip_bounds(S+1);
+	for (int sx = 0; sx <= S; sx += 1)
+		strip_bounds[sx] = count[sx*S];
+	const vector<int> strip_groups = groupRanges(strip_bounds);
+
+	vector<HullHandles> strips;
+	for (int g = 0; g+1 < strip_groups.size(); g += 1) {
+		const int first = strip_groups[g], last = strip_groups[g+1];
+		if (last != first+1) {
+			// joined strips : no cells.
+			strips.push_back(triangulateRange(strip_bounds[first], strip_bounds[last]-1));
+			continue;
+		}
+
+		vector<int> cell_bounds(count.begin() + first*S, count.begin() + (first+1)*S + 1);
+		const vector<int> cell_groups = groupRanges(cell_bounds);
+
+		vector<HullHandles> cells;
+		for (int h = 0; h+1 < cell_groups.size(); h += 1)
+			cells.push_back(triangulateRange(cell_bounds[cell_groups[h]], cell_bounds[cell_groups[h+1]]-1));
+		strips.push_back(mergeAll(cells, 1));
+	}
+	return mergeAll(strips, 0);
+}
+
+
+/** Moves the duplicates out of the lexico-sorted range [start, end]
+ *  (inclusive) of PTS to its end : of each run of equal points, the
+ *  first site in file order (the smallest index) stays. Returns the
+ *  number of sites which stay. */
+int DelaunaySubdivision::dropDuplicates(int start, int end) {
+	vector<int> dropped;
+	int m = start;
+	for (int i = start; i <= end; i += 1) {
+		int v = points[i];
+		if (m > start && *point_ptrs[v] == *point_ptrs[points[m-1]]) {
+			if (v < points[m-1]) std::swap(v, points[m-1]);
+			dropped.push_back(v);
+		} else {
+			points[m++] = v;
+		}
+	}
+	std::copy(dropped.begin(), dropped.end(), points.begin()+m);
+	return m - start;
+}
+
+
+/** Triangulates [start, end] (inclusive) with vertical cuts
+ *  and returns all the four extreme hull edges. */
+HullHandles DelaunaySubdivision::triangulateRange(int start, int end) {
+	lexicoSort(points, &point_ptrs, start, end);
+	return hullHandles(divideConquerVerticalCuts(start, end));
+}
+
+
+/** Merges the triangulations in HS, which are separated along AXIS
+ *  and ordered along it, pairwise in a balanced tree. */
+HullHandles DelaunaySubdivision::mergeAll(std::vector<HullHandles> &hs, int axis) {
+	while (hs.size() > 1) {
+		vector<HullHandles> merged;
+		for (int i = 0; i < hs.size(); i += 2) {
+			if (i+1 < hs.size()) merged.push_back(mergeHulls(hs[i], hs[i+1], axis));
+			else                 merged.push_back(hs[i]);
+		}
+		hs.swap(merged);
+	}
+	return hs[0];
+}
+
+
+/** Waits for the worker processes PIDS. Exits if one of them failed. */
+static void waitWorkers(const vector<pid_t> &pids) {
+	for (int i = 0; i < pids.size(); i += 1) {
+		int status;
+		if (waitpid(pids[i], &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+			cout << "Multi-process triangulation : worker "<<i<<" failed. Exiting.\n";
+			exit(-1);
+		}
+	}
+}
+
+
+/** Forks a worker process. Returns its pid in this process, 0 in it. */
+static pid_t forkWorker() {
+	cout.flush(); // else the worker writes out this process' buffer too
+	const pid_t pid = fork();
+	if (pid < 0) {
+		cout << "Multi-process triangulation : unable to fork. Exiting.\n";
+		exit(-1);
+	}
+	return pid;
+}
+
+
+/** Multi-process version of the VERTICAL CUTS divide-and-conquer.
+ *  The workers share the points with this process, as forked copies :
+ *  the files hold only the topology. Workers leave by _exit, once their
+ *  file is written, without freeing their copy of the subdivision. */
+std::pair<Edge::Ptr, Edge::Ptr> DelaunaySubdivision::divideConquerProcesses(int procs) {
+	checkRange(0, points.size()-1);
+	lexicoSort(points, &point_ptrs, 0, points.size()-1);
+	// no worker gets a duplicate : they stay at the end of PTS.
+	const int n = dropDuplicates(0, points.size()-1);
+	checkRange(0, n-1);
+	procs = std::max(1, std::min(procs, n/2));
+	initPredicates(); // once, before the workers copy this process
 
-		if (axis==1) { //horizontal cut : rotate handles
-			first_handles  = rotate_handles(first_handles);
-			second_handles = rotate_handles(second_handles);
+	vector<string> parts;
+	vector<pid_t> pids;
+	for (int k = 0; k < procs; k += 1) {
+		stringstream name;
+		name << out_prefix << ".part0." << k;
+		parts.push_back(name.str());
+		const int start = (long long) k * n / procs, end = (long long) (k+1) * n / procs - 1;
+		const pid_t pid = forkWorker();
+		if (pid == 0) {
+			writeTriangulationFile(parts.back(), divideConquerVerticalCuts(start, end));
+			_exit(0);
 		}
+		pids.push_back(pid);
+	}
+	waitWorkers(pids);
 
-		pair<Edge::Ptr, Edge::Ptr> outer_handles  = mergeTriangulations (first_handles, second_handles);
-		return ((axis==1)? unrotate_handles(outer_handles) : outer_handles);
+	// merge the seams pairwise, till two strips are left.
+	for (int level = 1; parts.size() > 2; level += 1) {
+		vector<string> merged;
+		pids.clear();
+		for (int j = 0; j+1 < parts.size(); j += 2) {
+			stringstream name;
+			name << out_prefix << ".part" << level << "." << j/2;
+			merged.push_back(name.str());
+			const pid_t pid = forkWorker();
+			if (pid == 0) {
+				std::pair<Edge::Ptr, Edge::Ptr> lhandles = readTriangulationFile(parts[j]);
+				std::pair<Edge::Ptr, Edge::Ptr> rhandles = readTriangulationFile(parts[j+1]);
+				writeTriangulationFile(merged.back(), mergeTriangulations(lhandles, rhandles));
+				_exit(0);
+			}
+			pids.push_back(pid);
+		}
+		waitWorkers(pids);
+		for (int j = 0; j+1 < parts.size(); j += 2) {
+			remove(parts[j].c_str());
+			remove(parts[j+1].c_str());
+		}
+		if (parts.size() % 2) merged.push_back(parts.back());
+		parts.swap(merged);
 	}
+
+	std::pair<Edge::Ptr, Edge::Ptr> handles = readTriangulationFile(parts[0]);
+	if (parts.size() == 2)
+		handles = mergeTriangulations(handles, readTriangulationFile(parts[1]));
+	for (int j = 0; j < parts.size(); j += 1) remove(parts[j].c_str());
+	return handles;
 }
 
 
@@ -230,21 +857,59 @@ DelaunaySubdivision::rotate_handles(std::pair<Edge::Ptr, Edge::Ptr> handles) {
 	return make_pair(lh, rh);
 }
 
-/** Rotate the handles.
- *  First handle (this is the BOTTOM handle) goes LEFT,
- *  Second handle  (this is the TOP handle) goes RIGHT. */
-std::pair<Edge::Ptr, Edge::Ptr>
-DelaunaySubdivision::unrotate_handles(std::pair<Edge::Ptr, Edge::Ptr> handles) {
-	Edge::Ptr bh = handles.first;
-	Edge::Ptr th = handles.second;
 
-	while(point_ptrs[bh->Rnext()->org()]->x() < point_ptrs[bh->org()]->x())
-		bh = bh->Rnext();
+/** Returns all the four extreme hull edges, given the LEFT, RIGHT handles.
+ *  Walks the hull : only meant for the (constant sized) base cases. */
+HullHandles DelaunaySubdivision::hullHandles(std::pair<Edge::Ptr, Edge::Ptr> handles) {
+	HullHandles hs;
+	hs.min[0] = handles.first;
+	hs.max[0] = handles.second;
+
+	std::pair<Edge::Ptr, Edge::Ptr> rotated = rotate_handles(handles);
+	hs.min[1] = rotated.first;
+	hs.max[1] = rotated.second;
+	return hs;
+}
+
+
+/** Merges triangulations separated along AXIS (0 : LEFT, RIGHT; 1 : BOTTOM, TOP)
+ *  and returns all the four extreme hull edges of the merged triangulation.
+ *
+ *  Along AXIS, the outer handles are returned by mergeTriangulations.
+ *  Across AXIS, the extreme vertex is the better of the two extremes of the
+ *  sub-triangulations. Its hull edge survives the merge, unless the vertex
+ *  is an end-point of a common tangent, in which case the tangent replaces it:
+ *    - ccw hull edges change at the first end-point of LOWER
+ *      and at the second end-point of UPPER,
+ *    - cw  hull edges change at the second end-point of LOWER
+ *      and at the first end-point of UPPER. */
+HullHandles DelaunaySubdivision::mergeHulls(const HullHandles &first,
+		const HullHandles &second, int axis) {
+	Edge::Ptr lower, upper;
+	std::pair<Edge::Ptr, Edge::Ptr> outer =
+			mergeTriangulations(make_pair(first.min[axis], first.max[axis]),
+					make_pair(second.min[axis], second.max[axis]), &lower, &upper);
+
+	HullHandles hs;
+	hs.min[axis] = outer.first;
+	hs.max[axis] = outer.second;
+
+	const int other = mod(axis+1, 2);
+	IndexedComparator comp(2, other, &point_ptrs);
 
-	while(point_ptrs[th->Lnext()->org()]->x() > point_ptrs[th->org()]->x())
-		th = th->Lnext();
+	Edge::Ptr lo = comp(second.min[other]->org(), first.min[other]->org())?
+			second.min[other] : first.min[other];
+	if      (lo->org() == lower->dest()) lo = lower->Sym();
+	else if (lo->org() == upper->org())  lo = upper;
 
-	return make_pair(bh, th);
+	Edge::Ptr hi = comp(first.max[other]->org(), second.max[other]->org())?
+			second.max[other] : first.max[other];
+	if      (hi->org() == lower->org())  hi = lower;
+	else if (hi->org() == upper->dest()) hi = upper->Sym();
+
+	hs.min[other] = lo;
+	hs.max[other] = hi;
+	return hs;
 }
 
 
@@ -259,7 +924,7 @@ DelaunaySubdivision::unrotate_handles(std::pair<Edge::Ptr, Edge::Ptr> handles) {
  *  Returns the outer handles.*/
 std::pair<Edge::Ptr, Edge::Ptr>
 DelaunaySubdivision::mergeTriangulations (std::pair<Edge::Ptr, Edge::Ptr> first_handles,
-		std::pair<Edge::Ptr, Edge::Ptr> second_handles) {
+		std::pair<Edge::Ptr, Edge::Ptr> second_handles, Edge::Ptr *lower, Edge::Ptr *upper) {
 	Edge::Ptr ldo = first_handles.first; Edge::Ptr ldi = first_handles.second;
 	Edge::Ptr rdi = second_handles.first; Edge::Ptr rdo = second_handles.second;
 
@@ -273,6 +938,7 @@ DelaunaySubdivision::mergeTriangulations (std::pair<Edge::Ptr, Edge::Ptr> first_
 	Edge::Ptr basel = connect(rdi->Sym(), ldi);
 	if ((*point_ptrs[ldi->org()]) == (*point_ptrs[ldo->org()])) 	ldo = basel->Sym();
 	if ((*point_ptrs[rdi->org()]) == (*point_ptrs[rdo->org()])) 	rdo = basel;
+	if (lower) *lower = basel;
 
 	// merge the two triangulations
 	while (true)  {
@@ -298,7 +964,10 @@ DelaunaySubdivision::mergeTriangulations (std::pair<Edge::Ptr, Edge::Ptr> first_
 		const bool rvalid = valid(rcand, basel);
 
 		// we have reached the upper common tangent. This exits out of the merge loop.
-		if (!lvalid && !rvalid) break;
+		if (!lvalid && !rvalid) {
+			if (upper) *upper = basel;
+			break;
+		}
 
 		// check which side to connect to.
 		const bool check =  (!lvalid || (rvalid && INCIRCLE(lcand->dest(), lcand->org(), rcand->org(), rcand->dest())));
@@ -307,24 +976,1897 @@ DelaunaySubdivision::mergeTriangulations (std::pair<Edge::Ptr, Edge::Ptr> first_
 	return make_pair(ldo, rdo);
 }
 
-/** Main interface function.*/
-void DelaunaySubdivision::computeDelaunay(CutsType t, bool time) {
-	clock_t tim;
-	int f;
-	tim = clock();
+/** Is the left face of the edge e a (ccw) triangle?
+ *  This is false for the outer face, i.e. to the left of cw hull edges. */
+bool DelaunaySubdivision::leftFaceIsTriangle(Edge::Ptr e) {
+	Edge::Ptr n = e->Lnext();
+	return (n->Lnext()->Lnext() == e) && CCW(e->org(), e->dest(), n->dest());
+}
 
-	if (t==VERTICAL_CUTS) {
-		lexicoSort(points, &point_ptrs, 0, points.size()-1);
-		std::pair<Edge::Ptr, Edge::Ptr> cvx_handles = divideConquerVerticalCuts(0, points.size()-1);
-		randEdge = cvx_handles.first->qEdge();
-	} else {
-		std::pair<Edge::Ptr, Edge::Ptr> cvx_handles = divideConquerAlternatingCuts(0, points.size()-1);
-		randEdge = cvx_handles.first->qEdge();
+
+/** Locates the point X by walking the triangulation from the edge START.
+ *  Returns an edge e such that :
+ *    - X is inside or on the triangle to the left of e, or
+ *    - X is outside the convex hull : e is a hull edge with the outer
+ *      face to its left and X strictly to its left.
+ *
+ *  This is a visibility walk : the triangle is left across an edge
+ *  which has X strictly to its right. Which of the two edges is tried first
+ *  alternates, so that the walk cannot cycle. */
+Edge::Ptr DelaunaySubdivision::locate(const Eigen::Vector2d &x, Edge::Ptr start) {
+	Edge::Ptr e = start;
+	if (cw(x, *point_ptrs[e->org()], *point_ptrs[e->dest()]))
+		e = e->Sym();
+
+	unsigned int coin = 0;
+	while (true) {
+		if (!leftFaceIsTriangle(e)) {
+			if (ccw(x, *point_ptrs[e->org()], *point_ptrs[e->dest()]))
+				return e;
+			// X is on the line of a hull edge : look on the inner side.
+			e = e->Sym();
+			if (!leftFaceIsTriangle(e)) return e;
+		}
+
+		Edge::Ptr f[2] = {e->Lnext(), e->Lprev()};
+		coin += 1;
+		const int k = coin & 1;
+		if (cw(x, *point_ptrs[f[k]->org()], *point_ptrs[f[k]->dest()]))
+			e = f[k]->Sym();
+		else if (cw(x, *point_ptrs[f[1-k]->org()], *point_ptrs[f[1-k]->dest()]))
+			e = f[1-k]->Sym();
+		else
+			return e;
+	}
+}
+
+
+/** Inserts the point with index X into the triangulation,
+ *  searching for it from the edge HINT. Based on G&S [pg. 120].
+ *  Returns an edge whose origin is at X. If X duplicates a vertex
+ *  already present, it is not inserted and an edge out of that vertex is returned.
+ *  With weights, a point hidden by its triangle is not inserted either. */
+Edge::Ptr DelaunaySubdivision::insertPoint(int x, Edge::Ptr hint) {
+	const Vector2d &p = *point_ptrs[x];
+	Edge::Ptr e = locate(p, hint);
+	vector<Edge::Ptr> stack;
+
+	if (!leftFaceIsTriangle(e)) {
+		if (!leftOf(x, e)) {
+			cout << "Delaunay insertion : no triangle to insert into. Exiting.\n";
+			exit(-1);
+		}
+		Edge::Ptr xe = connectOutside(x, e, stack);
+		return flipAround(x, stack, xe);
+	}
+
+	// X is inside or on the triangle to the left of e.
+	if (p == *point_ptrs[e->org()])          return coincide(x, e);
+	if (p == *point_ptrs[e->dest()])         return coincide(x, e->Sym());
+	if (p == *point_ptrs[e->Lprev()->org()]) return coincide(x, e->Lprev());
+
+	// a weighted point under the plane of its triangle is not a vertex.
+	if (!weights.empty() && !INCIRCLE(e->org(), e->dest(), e->Lprev()->org(), x)) {
+		hidden.push_back(x);
+		return e;
+	}
+
+	// is X on an edge of the triangle?
+	if      (!leftOf(x, e->Lnext())) e = e->Lnext();
+	else if (!leftOf(x, e->Lprev())) e = e->Lprev();
+	return connectInside(x, e, !leftOf(x, e));
+}
+
+
+/** X is at the position of the vertex at the origin of S. Without weights
+ *  it is a duplicate, and is dropped. With weights, the lighter one is
+ *  hidden; if that is the vertex, X takes over its edges, and the
+ *  triangles around them are flipped regular, as for a new point. */
+Edge::Ptr DelaunaySubdivision::coincide(int x, Edge::Ptr s) {
+	if (weights.empty() || weights[x] <= weights[s->org()]) {
+		if (!weights.empty()) hidden.push_back(x);
+		return s;
+	}
+	hidden.push_back(s->org());
+	vector<Edge::Ptr> stack;
+	Edge::Ptr f = s;
+	do {
+		f->setOrg(x);
+		if (leftFaceIsTriangle(f)) stack.push_back(f->Lnext());
+		f = f->Onext();
+	} while (f != s);
+	return flipAround(x, stack, s);
+}
+
+
+/** Connects X to the vertices of the triangle to the left of E, in which it
+ *  lies, or, with ON_EDGE, of the two triangles on either side of E, on
+ *  which it lies. Then flips till it is Delaunay, and returns an edge whose
+ *  origin is at X. A constrained edge E is split in two constrained edges. */
+Edge::Ptr DelaunaySubdivision::connectInside(int x, Edge::Ptr e, bool on_edge) {
+	vector<Edge::Ptr> stack;
+	bool on_hull = false;
+	int segment[2] = {-1, -1}; // the ends of a constrained edge through X
+	if (on_edge) {
+		if (e->qEdge()->constrained) {
+			segment[0] = e->org();
+			segment[1] = e->dest();
+		}
+		if (leftFaceIsTriangle(e->Sym())) {
+			// remove the edge : X is now inside a quadrilateral.
+			Edge::Ptr t = e->Oprev();
+			deleteEdge(e);
+			e = t;
+		} else {
+			// split the hull edge after connecting X to the triangle.
+			on_hull = true;
+		}
+	}
+
+	// connect X to the vertices of the face to the left of e.
+	Edge::Ptr base  = QuadEdge::makeEdge();
+	base->setOrg(e->org());
+	base->setDest(x);
+	Edge::splice(base, e);
+	Edge::Ptr start = base;
+	do {
+		stack.push_back(e);
+		base = connect(e, base->Sym());
+		e = base->Oprev();
+	} while (e->Lnext() != start);
+	stack.push_back(e);
+
+	if (on_hull) {
+		// the first face edge is the hull edge through X.
+		deleteEdge(stack.front());
+		stack.erase(stack.begin());
+	}
+
+	if (segment[0] >= 0) {
+		// the two halves of the split segment stay constrained.
+		Edge::Ptr f = base->Sym();
+		do {
+			if (f->dest() == segment[0] || f->dest() == segment[1])
+				f->qEdge()->constrained = true;
+			f = f->Onext();
+		} while (f != base->Sym());
+	}
+
+	return flipAround(x, stack, base->Sym());
+}
+
+
+/** Connects X, which lies outside the convex hull, to the hull edges visible from it.
+ *  E is a visible hull edge (outer face to its left, X strictly to its left).
+ *  The visible hull edges are pushed onto STACK.
+ *  Returns an edge whose origin is at X. */
+Edge::Ptr DelaunaySubdivision::connectOutside(int x, Edge::Ptr e, std::vector<Edge::Ptr> &stack) {
+	// the visible edges form a chain along the outer face.
+	Edge::Ptr first = e, last = e;
+	while (leftOf(x, first->Lprev())) first = first->Lprev();
+	while (leftOf(x, last->Lnext()))  last  = last->Lnext();
+
+	Edge::Ptr base = QuadEdge::makeEdge();
+	base->setOrg(first->org());
+	base->setDest(x);
+	Edge::splice(base, first);
+
+	Edge::Ptr f = first;
+	while (true) {
+		Edge::Ptr next = f->Lnext();
+		base = connect(f, base->Sym());
+		stack.push_back(f);
+		if (f == last) break;
+		f = next;
+	}
+	return base->Sym();
+}
+
+
+/** Flips edges till all the triangles incident to the new point X are Delaunay.
+ *  STACK holds the edges opposite to X (X to their left) which need to be checked.
+ *  An edge is flipped if the apex of the triangle on its right is inside the
+ *  circumcircle of the triangle with X; the two outer edges of that triangle
+ *  are then opposite to X, and need to be checked. From G&S [pg. 120].
+ *  With weights (Edelsbrunner and Shah [1996]), the power test stands for
+ *  the circumcircle, and the quadrilateral may be reflex : it then takes a
+ *  3-1 flip (see hideVertex), or, if the reflex vertex has more neighbours,
+ *  waits for the flips of the other link edges around it.
+ *  Returns XE, an edge out of X, or another one if a 3-1 flip deleted it. */
+Edge::Ptr DelaunaySubdivision::flipAround(int x, std::vector<Edge::Ptr> &stack, Edge::Ptr xe) {
+	while (!stack.empty()) {
+		Edge::Ptr e = stack.back();
+		stack.pop_back();
+		if (!e->qEdge()) continue; // deleted by a 3-1 flip
+
+		Edge::Ptr t = e->Oprev();
+		if (rightOf(t->dest(), e) && INCIRCLE(e->org(), t->dest(), e->dest(), x)) {
+			if (!weights.empty() && !(CCW(x, e->org(), t->dest()) && CCW(x, t->dest(), e->dest()))) {
+				Edge::Ptr out = hideVertex(x, e, t, stack);
+				if (out) xe = out;
+				continue;
+			}
+			Edge::Ptr t_next = t->Lnext();
+			if (swap(e)) {
+				stack.push_back(t);
+				stack.push_back(t_next);
+			}
+		}
+	}
+	return xe;
+}
+
+
+/** The 3-1 flip : the end V of E at which the quadrilateral X, E, T is
+ *  reflex must have the degree 3 (its neighbours are then X, the apex R
+ *  of T and the other end of E); its three triangles merge into one, and V
+ *  is hidden. If V is flat instead (on the segment X-R), its four triangles
+ *  become two, across the new edge X-R, or, on the hull, its two triangles
+ *  become one, and X-R a hull edge. The new link edges go on STACK.
+ *  Returns an edge out of X, or NULL if V has more neighbours (nothing is
+ *  changed then). */
+Edge::Ptr DelaunaySubdivision::hideVertex(int x, Edge::Ptr e, Edge::Ptr t,
+		std::vector<Edge::Ptr> &stack) {
+	const int r = t->dest();
+	const bool at_org = !CCW(x, e->org(), r);
+	Edge::Ptr s = at_org? e : e->Sym();
+	const bool flat = orient2d(*point_ptrs[x], *point_ptrs[s->org()], *point_ptrs[r]) == 0.0;
+
+	// the edges out of V. The faces are triangles but, for a flat V on
+	// the hull, the outer face across X-R.
+	Edge::Ptr ring[4];
+	int degree = 0, open = 0;
+	Edge::Ptr f = s;
+	do {
+		if (degree == 4) return Edge::Ptr();
+		ring[degree++] = f;
+		open += !leftFaceIsTriangle(f);
+		f = f->Onext();
+	} while (f != s);
+	const bool ok = flat? (degree == 4 && open == 0) || (degree == 3 && open == 1)
+	                    : (degree == 3 && open == 0);
+	if (!ok) return Edge::Ptr();
+
+	// the edge of the triangle of E and T which V does not touch.
+	Edge::Ptr link = at_org? t->Lnext() : t;
+	hidden.push_back(s->org());
+	for (int k = 0; k < degree; k += 1) deleteEdge(ring[k]);
+	stack.push_back(link);
+	if (!flat) return link->Lprev();
+
+	// X-R splits the face left : its other half, if it is not the
+	// outer face, has a link edge too.
+	if (at_org) {
+		Edge::Ptr xr = connect(link->Lnext(), link);
+		if (!open) stack.push_back(xr->Sym()->Lprev());
+		return xr;
+	}
+	Edge::Ptr xr = connect(link->Lprev()->Lprev(), link->Lnext());
+	if (!open) stack.push_back(xr->Lnext());
+	return xr;
+}
+
+
+/** Lawson's flip algorithm : flips the edges in STACK (and the edges
+ *  of the quadrilaterals they are flipped in) till they are locally Delaunay.
+ *  Hull edges, whose apexes are not on both sides, are skipped.
+ *  Works on any triangulation of the convex hull. */
+void DelaunaySubdivision::lawsonFlip(std::vector<Edge::Ptr> &stack) {
+	while (!stack.empty()) {
+		Edge::Ptr e = stack.back();
+		stack.pop_back();
+
+		const int l = e->Onext()->dest();
+		const int r = e->Oprev()->dest();
+		if (!leftOf(l, e) || !rightOf(r, e)) continue;
+
+		if (INCIRCLE(e->org(), e->dest(), l, r)) {
+			Edge::Ptr quad[4] = {e->Lnext(), e->Lprev(), e->Rnext(), e->Rprev()};
+			if (swap(e)) stack.insert(stack.end(), quad, quad+4);
+		}
+	}
+}
+
+
+/** Pseudo-angle of the direction D, monotonic in the angle, in [0,1). */
+static double pseudoAngle(const Vector2d &d) {
+	const double p = d.x() / (fabs(d.x()) + fabs(d.y()));
+	return ((d.y() > 0.0)? 3.0 - p : 1.0 + p) / 4.0;
+}
+
+/** Compares the indices of points by their distance from a center.*/
+struct RadialComparator {
+	const vector<double> &dist;
+	RadialComparator(const vector<double> &_dist) : dist(_dist) {}
+	bool operator() (const int &i, const int &j) const {
+		return (dist[i] < dist[j]) || (dist[i] == dist[j] && i < j);
+	}
+};
+
+
+/** Radial sweep-hull (s-hull) delaunay triangulation [Sinclair, 2010].
+ *
+ *  Seeds a triangle with a small circumcircle near the middle of the points.
+ *  The other points are added in the order of their distance from its
+ *  circumcenter : each one is outside the current hull, and is connected to
+ *  the hull edges visible from it. An angular hash of the hull vertices about
+ *  the center gives a nearby hull edge to start the search from.
+ *  No edge is flipped while sweeping; a single Lawson pass over the new
+ *  edges makes the triangulation Delaunay at the end.
+ *
+ *  Returns an edge of the triangulation, or a NULL pointer
+ *  if all the points are collinear. */
+Edge::Ptr DelaunaySubdivision::sweepHullDelaunay() {
+	const int N = points.size();
+
+	Vector2d lo = *point_ptrs[points[0]], hi = lo;
+	for (int i = 1; i < N; i += 1) {
+		lo = lo.cwiseMin(*point_ptrs[points[i]]);
+		hi = hi.cwiseMax(*point_ptrs[points[i]]);
+	}
+	const Vector2d mid = 0.5*(lo + hi);
+
+	// seed : the point closest to the middle, its nearest neighbour,
+	// and the point which makes the smallest circumcircle with them.
+	int s0 = points[0];
+	for (int i = 1; i < N; i += 1)
+		if ((*point_ptrs[points[i]] - mid).squaredNorm() < (*point_ptrs[s0] - mid).squaredNorm())
+			s0 = points[i];
+
+	int s1 = -1;
+	double best = std::numeric_limits<double>::infinity();
+	for (int i = 0; i < N; i += 1) {
+		const double d = (*point_ptrs[points[i]] - *point_ptrs[s0]).squaredNorm();
+		if (d > 0.0 && d < best) {best = d; s1 = points[i];}
+	}
+	if (s1 < 0) return Edge::Ptr();
+
+	int s2 = -1;
+	best = std::numeric_limits<double>::infinity();
+	for (int i = 0; i < N; i += 1) {
+		const int p = points[i];
+		if (!CCW(s0, s1, p) && !CCW(s0, p, s1)) continue;
+		const double r = (circumcenter(*point_ptrs[s0], *point_ptrs[s1], *point_ptrs[p])
+				- *point_ptrs[s0]).squaredNorm();
+		if (r < best) {best = r; s2 = p;}
+	}
+	if (s2 < 0) return Edge::Ptr();
+	if (!CCW(s0, s1, s2)) std::swap(s1, s2);
+
+	const Vector2d center = circumcenter(*point_ptrs[s0], *point_ptrs[s1], *point_ptrs[s2]);
+
+	// sort by distance from the center.
+	vector<double> dist(point_ptrs.size(), 0.0);
+	for (int i = 0; i < N; i += 1)
+		dist[points[i]] = (*point_ptrs[points[i]] - center).squaredNorm();
+	vector<int> order(points);
+	std::sort(order.begin(), order.end(), RadialComparator(dist));
+
+	// seed triangle
+	Edge::Ptr a = QuadEdge::makeEdge();
+	Edge::Ptr b = QuadEdge::makeEdge();
+	Edge::splice(a->Sym(), b);
+	a->setOrg(s0); a->setDest(s1);
+	b->setOrg(s1); b->setDest(s2);
+	Edge::Ptr c = connect(b, a);
+
+	// hull_edge[v] : the hull edge out of v, with the outer face to its left.
+	vector<Edge::Ptr> hull_edge(point_ptrs.size());
+	vector<char>      on_hull(point_ptrs.size(), 0);
+	hull_edge[s0] = c->Sym(); hull_edge[s1] = a->Sym(); hull_edge[s2] = b->Sym();
+	on_hull[s0] = on_hull[s1] = on_hull[s2] = 1;
+
+	const int H = std::max(1, (int) ceil(sqrt((double) N)));
+	vector<int> hash(H, -1);
+	const int seeds[3] = {s0, s1, s2};
+	for (int k = 0; k < 3; k += 1)
+		hash[std::min(H-1, (int) (pseudoAngle(*point_ptrs[seeds[k]] - center) * H))] = seeds[k];
+
+	vector<Edge::Ptr> stack;
+	Edge::Ptr hint = a;
+	for (int i = 0; i < N; i += 1) {
+		const int x = order[i];
+		if (x == s0 || x == s1 || x == s2) continue;
+
+		// a hull vertex near x in angle
+		const int key = std::min(H-1, (int) (pseudoAngle(*point_ptrs[x] - center) * H));
+		int start = -1;
+		for (int j = 0; j < H && start < 0; j += 1) {
+			const int v = hash[(key + j) % H];
+			if (v >= 0 && on_hull[v]) start = v;
+		}
+
+		// walk along the hull to an edge visible from x
+		Edge::Ptr e = hull_edge[start];
+		bool visible = leftOf(x, e);
+		for (Edge::Ptr f = e->Lnext(); !visible && f != hull_edge[start]; f = f->Lnext()) {
+			e = f;
+			visible = leftOf(x, e);
+		}
+
+		if (!visible) {
+			// not outside the hull (a duplicate point, or a tie in distance).
+			hint = insertPoint(x, hint);
+			if (hint->org() != x) continue;
+		} else {
+			vector<Edge::Ptr> chain;
+			hint = connectOutside(x, e, chain);
+
+			const int u = chain.front()->org();
+			for (int k = 1; k < chain.size(); k += 1)
+				on_hull[chain[k]->org()] = 0;
+			hull_edge[x] = hint;
+			hull_edge[u] = hint->Lprev();
+			on_hull[x]   = 1;
+			hash[key] = x;
+			hash[std::min(H-1, (int) (pseudoAngle(*point_ptrs[u] - center) * H))] = u;
+			stack.insert(stack.end(), chain.begin(), chain.end());
+		}
+
+		// the new edges out of x
+		Edge::Ptr f = hint;
+		do {
+			stack.push_back(f);
+			f = f->Onext();
+		} while (f != hint);
+	}
+
+	lawsonFlip(stack);
+	return hint;
+}
+
+
+/** Orders the points in a Biased Randomized Insertion Order :
+ *  rounds of geometrically increasing size, each sorted along a Hilbert curve.
+ *  The last round has (about) half of the points, the one before a quarter, etc.
+ *  [Amenta, Choi & Rote, 2003] */
+void DelaunaySubdivision::brioOrder(std::vector<int> &order) {
+	order = points;
+	const int N = order.size();
+
+	// a fixed seed keeps the runs reproducible.
+	boost::mt19937 rng(274);
+	for (int i = N-1; i > 0; i -= 1)
+		std::swap(order[i], order[rng() % (i+1)]);
+
+	int end = N;
+	while (end > 0) {
+		const int start = (end > 64)? end/2 : 0;
+		hilbertSort(order, &point_ptrs, start, end-1);
+		end = start;
+	}
+}
+
+
+/** Randomized incremental delaunay triangulation.
+ *  Inserts the points in BRIO order, locating each one by
+ *  walking from the previously inserted point.
+ *  Returns an edge of the triangulation, or a NULL pointer
+ *  if all the points are collinear (no triangle can be seeded). */
+Edge::Ptr DelaunaySubdivision::incrementalDelaunay() {
+	vector<int> order;
+	brioOrder(order);
+	const int N = order.size();
+
+	// seed with the first triangle which is not degenerate.
+	int i1 = 1;
+	while (i1 < N && *point_ptrs[order[i1]] == *point_ptrs[order[0]]) i1 += 1;
+	int i2 = i1+1;
+	while (i2 < N && !CCW(order[0], order[i1], order[i2]) && !CCW(order[0], order[i2], order[i1])) i2 += 1;
+	if (i2 >= N) return Edge::Ptr();
+
+	int p1 = order[0], p2 = order[i1], p3 = order[i2];
+	if (!CCW(p1, p2, p3)) std::swap(p2, p3);
+
+	Edge::Ptr a = QuadEdge::makeEdge();
+	Edge::Ptr b = QuadEdge::makeEdge();
+	Edge::splice(a->Sym(), b);
+	a->setOrg(p1); a->setDest(p2);
+	b->setOrg(p2); b->setDest(p3);
+	connect(b, a);
+
+	Edge::Ptr hint = a;
+	for (int i = 1; i < N; i += 1) {
+		if (i == i1 || i == i2) continue;
+		hint = insertPoint(order[i], hint);
+	}
+	return hint;
+}
+
+
+/** Scans the points for the bounding box and exact duplicates, and
+ *  buckets a fixed size sample of them to measure clustering. O(n). */
+InputProfile DelaunaySubdivision::probeInput() {
+	InputProfile p;
+	const int N = points.size();
+	p.n = N;
+
+	// bounding box and exact duplicates : over all the points,
+	// as a single duplicate breaks the divide-and-conquer.
+	Vector2d lo = *point_ptrs[points[0]], hi = lo;
+	boost::unordered_set<std::pair<double, double> > seen;
+	seen.rehash(2*N);
+	p.duplicates = 0;
+	for (int i = 0; i < N; i += 1) {
+		const Vector2d &v = *point_ptrs[points[i]];
+		lo = lo.cwiseMin(v);
+		hi = hi.cwiseMax(v);
+		if (!seen.insert(std::make_pair(v.x(), v.y())).second)
+			p.duplicates += 1;
+	}
+	const Vector2d span = hi - lo;
+	p.tall   = span.y() > span.x();
+	const double lng = span.maxCoeff(), shrt = span.minCoeff();
+	p.aspect = (shrt > 0)? lng/shrt : (lng > 0? INFINITY : 1.0);
+
+	// the rest is measured on an evenly strided sample.
+	const int S      = std::min(N, 4096);
+	const int stride = N/S;
+	int num_integral = 0;
+
+	// about 4 points per cell, with the cells as square as the box allows.
+	const int cells = std::max(1, S/4);
+	int kx = 1, ky = 1;
+	if (span.x() > 0 && span.y() > 0) {
+		kx = std::max(1, std::min(cells, (int) std::sqrt(cells*span.x()/span.y())));
+		ky = std::max(1, cells/kx);
+	} else if (span.x() > 0) {
+		kx = cells;
+	} else if (span.y() > 0) {
+		ky = cells;
+	}
+	vector<int> counts(kx*ky, 0);
+	for (int i = 0; i < S; i += 1) {
+		const Vector2d &v = *point_ptrs[points[i*stride]];
+		num_integral += (v.x() == std::floor(v.x())) + (v.y() == std::floor(v.y()));
+		const int cx = (span.x() > 0)? std::min(kx-1, (int) (kx*(v.x()-lo.x())/span.x())) : 0;
+		const int cy = (span.y() > 0)? std::min(ky-1, (int) (ky*(v.y()-lo.y())/span.y())) : 0;
+		counts[cy*kx + cx] += 1;
+	}
+	p.integral_frac = num_integral/(2.0*S);
+	p.empty_frac    = std::count(counts.begin(), counts.end(), 0)/(double) counts.size();
+	return p;
+}
+
+
+/** Picks the algorithm (and sets num_threads) suited to the profile P.
+ *  The thresholds come from timing every algorithm on 100k
+ *  uniform, clustered, lattice and stretched point sets. */
+CutsType DelaunaySubdivision::chooseAlgorithm(const InputProfile &p) {
+	// a sub-problem per thread, as long as each one has some work. The
+	// 32768 points per thread were tuned on the merge-based engine, and are
+	// carried over untested on several cores for the seam-first one : on a
+	// single core, it runs 5-25% slower on 2-4 threads than on one for
+	// 16k-131k uniform points, which is what the threads have to win back.
+	const int threads = std::min(num_threads, std::max(1, p.n/32768));
+
+	// only the incremental, sweep-hull and seam-first algorithms skip
+	// duplicates.
+	if (p.duplicates > 0) {
+		if (threads == 1) return INCREMENTAL;
+		num_threads = threads;
+		return PARALLEL_CUTS;
+	}
+
+	// very thin boxes : the cuts across the long side give well shaped
+	// sub-problems only when that side is x; else sweep radially.
+	if (p.aspect >= 256)
+		return p.tall? SWEEP_HULL : VERTICAL_CUTS;
+
+	if (threads > 1) {
+		num_threads = threads;
+		return PARALLEL_CUTS;
+	}
+
+	// nearly uniform in a squarish box : cell bucketing is linear.
+	if (p.empty_frac < 0.1 && p.aspect < 8)
+		return DWYER_CUTS;
+
+	// clustered inputs : the alternating cuts adapt to the point density.
+	return ALTERNATE_CUTS;
+}
+
+
+/** Collects all the quad-edges reachable from randEdge. */
+void DelaunaySubdivision::collectQuadEdges(std::vector<QuadEdge::Ptr> &qedges) {
+	boost::unordered_set<QuadEdge*> seen;
+	seen.rehash(4*points.size()); // ~3n edges
+	vector<Edge::Ptr> stack(1, randEdge->edges[0]);
+	seen.insert(randEdge.get());
+	while (!stack.empty()) {
+		Edge::Ptr e = stack.back();
+		stack.pop_back();
+		qedges.push_back(e->qEdge());
+
+		// the next edges in the rings of its two ends : following Onext
+		// goes around each ring, so Oprev is not needed.
+		Edge::Ptr nbrs[2] = {e->Onext(), e->Sym()->Onext()};
+		for (int i = 0; i < 2; i += 1)
+			if (seen.insert(nbrs[i]->qEdge().get()).second) stack.push_back(nbrs[i]);
+	}
+}
+
+
+/** Frees all the quad-edges of the subdivision. */
+void DelaunaySubdivision::clearSubdivision() {
+	vector<QuadEdge::Ptr> qedges;
+	collectQuadEdges(qedges);
+	for (int i = 0; i < qedges.size(); i += 1)
+		qedges[i]->freePointers();
+	randEdge.reset();
+	hull_edge.reset();
+	site_edges.clear();
+}
+
+
+/** Fills site_edges with an edge out of every vertex. O(n). */
+void DelaunaySubdivision::indexSites() {
+	site_edges.assign(point_ptrs.size(), Edge::Ptr());
+	vector<QuadEdge::Ptr> qedges;
+	collectQuadEdges(qedges);
+	for (int i = 0; i < qedges.size(); i += 1) {
+		Edge::Ptr e = qedges[i]->edges[0];
+		site_edges[e->org()]  = e;
+		site_edges[e->dest()] = e->Sym();
+	}
+}
+
+
+/** Returns the edge of site_edges out of V,
+ *  or a NULL pointer if it has been deleted or flipped away from V. */
+Edge::Ptr DelaunaySubdivision::siteEdge(int v) {
+	Edge::Ptr e = site_edges[v];
+	if (!e || !e->qEdge() || e->org() != v) return Edge::Ptr();
+	return e;
+}
+
+
+/** Points site_edges of E's origin and of all its neighbours at E's ring.
+ *  An insertion only deletes or flips edges between the neighbours
+ *  of the new vertex, so this keeps all the entries valid. */
+void DelaunaySubdivision::refreshRing(Edge::Ptr e) {
+	site_edges[e->org()] = e;
+	Edge::Ptr f = e;
+	do {
+		site_edges[f->dest()] = f->Sym();
+		f = f->Onext();
+	} while (f != e);
+}
+
+
+/** Jump-and-walk [Mucke et al., 1996] start : returns an edge out of
+ *  the vertex nearest to P among ~n^(1/3) random vertices.
+ *  The walk from there crosses O(n^(1/3)) triangles on expectation. */
+Edge::Ptr DelaunaySubdivision::nearbyEdge(const Eigen::Vector2d &p) {
+	const int N = points.size();
+	const int samples = 16*(int) std::ceil(std::pow((double) N, 1.0/3.0));
+
+	// compare the points first : only the nearest one's edge is looked up.
+	int best = -1;
+	double best_d = INFINITY;
+	for (int i = 0; i < samples; i += 1) {
+		const int v = points[rng() % N];
+		if (!point_ptrs[v]) continue; // removed
+		const double d = (*point_ptrs[v] - p).squaredNorm();
+		if (d < best_d) {
+			best   = v;
+			best_d = d;
+		}
+	}
+	if (best < 0) return randEdge->edges[0];
+	Edge::Ptr e = siteEdge(best);
+	return e? e : randEdge->edges[0];
+}
+
+
+/** Inserts the new site (X, Y) into the triangulation computed by
+ *  computeDelaunay, and keeps it Delaunay.*/
+Edge::Ptr DelaunaySubdivision::insertSite(double x, double y) {
+	const int id = point_ptrs.size();
+	Edge::Ptr e = insertSiteIndex(id, Vector2dPtr(new Vector2d(x,y)));
+	if (e->org() != id) {
+		// a duplicate : give its index back.
+		point_ptrs.pop_back();
+		site_edges.pop_back();
+	}
+	return e;
+}
+
+
+/** Inserts the site P with the index ID, which is not in use in this
+ *  subdivision. The search starts at HINT, if given.*/
+Edge::Ptr DelaunaySubdivision::insertSiteIndex(int id, Vector2dPtr p, Edge::Ptr hint) {
+	if (!randEdge) {
+		cout << "Site insertion : compute the triangulation first. Exiting.\n";
+		exit(-1);
+	}
+	if (!weights.empty()) {
+		cout << "Site insertion : not supported on a regular triangulation. Exiting.\n";
+		exit(-1);
+	}
+	if (site_edges.size() != point_ptrs.size()) indexSites();
+	if (id >= point_ptrs.size()) {
+		point_ptrs.resize(id+1);
+		site_edges.resize(id+1);
+	}
+	point_ptrs[id] = p;
+	points.push_back(id);
+
+	Edge::Ptr e = randEdge->edges[0];
+	if (!leftFaceIsTriangle(e) && !leftFaceIsTriangle(e->Sym())) {
+		// the points are all collinear so far : there is no triangle
+		// to walk to. Rebuild, which is rare and O(n log n).
+		for (int i = 0; i+1 < points.size(); i += 1) {
+			if (point_ptrs[points[i]] && *point_ptrs[points[i]] == *p) {
+				points.pop_back();
+				point_ptrs[id].reset();
+				return siteEdge(points[i]);
+			}
+		}
+		clearSubdivision();
+		computeDelaunay(VERTICAL_CUTS);
+		indexSites();
+		return site_edges[id];
+	}
+
+	e = insertPoint(id, hint? hint : nearbyEdge(*p));
+	if (e->org() != id) {
+		// a duplicate : it was not inserted.
+		points.pop_back();
+		point_ptrs[id].reset();
+		return e;
+	}
+
+	// randEdge may have been deleted : the edges out of the new site are not.
+	randEdge = e->qEdge();
+	refreshRing(e);
+	return e;
+}
+
+
+/** Devillers' [1999] priority of the ear (A, B, C) of the star of
+ *  the removed vertex X : the power of X wrt the circle through A, B, C.
+ *  As incircle is the orientation times minus the power, no
+ *  circumcenter has to be constructed. */
+double DelaunaySubdivision::earPower(int a, int b, int c, int x) {
+	const Vector2d &pa = *point_ptrs[a], &pb = *point_ptrs[b], &pc = *point_ptrs[c];
+	return -incircle(pa, pb, pc, *point_ptrs[x]) / orient2d(pa, pb, pc);
+}
+
+
+/** Removes the site ID from the triangulation and re-triangulates its star.
+ *
+ *  The link of ID is a polygon (a chain, if ID is on the hull) whose
+ *  edges are kept. The convex ears of the link are queued on their
+ *  power, and the largest one is closed off with connect() till a
+ *  triangle (or, on the hull, a convex chain) is left. A Lawson pass over
+ *  the new edges then guards against round-off in the powers; the
+ *  convexity tests are exact. */
+bool DelaunaySubdivision::removeSite(int id) {
+	if (id < 0 || id >= point_ptrs.size() || !point_ptrs[id]) return false;
+	if (!randEdge) {
+		cout << "Site removal : compute the triangulation first. Exiting.\n";
+		exit(-1);
+	}
+	if (!weights.empty()) {
+		cout << "Site removal : not supported on a regular triangulation. Exiting.\n";
+		exit(-1);
+	}
+	if (site_edges.size() != point_ptrs.size()) indexSites();
+	Edge::Ptr e0 = siteEdge(id);
+	if (!e0) return false; // a duplicate which was never inserted.
+
+	// the edges out of ID in ccw order, starting after the outer face.
+	vector<Edge::Ptr> ring;
+	Edge::Ptr start = e0, f = e0;
+	bool on_hull = false, any_triangle = false;
+	do {
+		if (leftFaceIsTriangle(f)) {
+			any_triangle = true;
+		} else {
+			on_hull = true;
+			start   = f->Onext();
+		}
+		f = f->Onext();
+	} while (f != e0);
+	f = start;
+	do {
+		ring.push_back(f);
+		f = f->Onext();
+	} while (f != start);
+	const int K = ring.size();
+
+	if (!any_triangle) {
+		// collinear points : ID is on a chain of edges.
+		if (K == 1 && ring[0]->Sym()->Onext() == ring[0]->Sym()) {
+			cout << "Site removal : need at least two sites left. Exiting.\n";
+			exit(-1);
+		}
+		Edge::Ptr keep = ring[0]->Sym()->Onext();
+		if (K == 2) {
+			keep = connect(ring[0], ring[1]->Sym());
+			site_edges[keep->dest()] = keep->Sym();
+		}
+		site_edges[keep->org()] = keep;
+		for (int i = 0; i < K; i += 1) deleteEdge(ring[i]);
+		randEdge = keep->qEdge();
+		point_ptrs[id].reset();
+		site_edges[id].reset();
+		return true;
+	}
+
+	// the link : v[i] = dest of ring[i]; out[i] is the edge v[i] -> v[i+1].
+	vector<int> v(K), prev(K), next(K);
+	vector<Edge::Ptr> out(K);
+	for (int i = 0; i < K; i += 1) {
+		v[i]    = ring[i]->dest();
+		prev[i] = i-1;
+		next[i] = i+1;
+		if (!on_hull || i < K-1) out[i] = ring[i]->Lnext();
+	}
+	if (on_hull) {
+		next[K-1] = -1;
+	} else {
+		prev[0]   = K-1;
+		next[K-1] = 0;
+	}
+	vector<Edge::Ptr> stack(out.begin(), on_hull? out.end()-1 : out.end());
+	for (int i = 0; i < K-1; i += 1) site_edges[v[i]] = out[i];
+	site_edges[v[K-1]] = on_hull? out[K-2]->Sym() : out[K-1];
+
+	for (int i = 0; i < K; i += 1) deleteEdge(ring[i]);
+	randEdge = out[0]->qEdge();
+
+	// ear queue : (power, (vertex, stamp)); stale entries are skipped.
+	typedef std::pair<double, std::pair<int, int> > Ear;
+	std::priority_queue<Ear> ears;
+	vector<int> stamp(K, 0);
+	for (int i = 0; i < K; i += 1) {
+		if (prev[i] >= 0 && next[i] >= 0 && CCW(v[prev[i]], v[i], v[next[i]]))
+			ears.push(Ear(earPower(v[prev[i]], v[i], v[next[i]], id), std::make_pair(i, 0)));
+	}
+
+	int left = K;
+	while (!ears.empty() && (on_hull || left > 3)) {
+		const int i = ears.top().second.first;
+		const int s = ears.top().second.second;
+		ears.pop();
+		if (s != stamp[i]) continue;
+
+		const int j = prev[i], l = next[i];
+		Edge::Ptr e = connect(out[i], out[j]);
+		stack.push_back(e);
+		out[j]  = e->Sym();
+		next[j] = l;
+		prev[l] = j;
+		stamp[i] = -1;
+		left -= 1;
+
+		const int ends[2] = {j, l};
+		for (int t = 0; t < 2; t += 1) {
+			const int c = ends[t];
+			stamp[c] += 1;
+			if (prev[c] >= 0 && next[c] >= 0 && CCW(v[prev[c]], v[c], v[next[c]]))
+				ears.push(Ear(earPower(v[prev[c]], v[c], v[next[c]], id), std::make_pair(c, stamp[c])));
+		}
+	}
+	lawsonFlip(stack);
+
+	point_ptrs[id].reset();
+	site_edges[id].reset();
+	return true;
+}
+
+
+/** Are all the faces around the origin V of E0 ccw triangles? Returns 1
+ *  if so, -1 if one of them is turned over (or flat), and 0 else : V is on
+ *  the hull. For a vertex which has just moved, in a triangulation which
+ *  was valid, 1 means its star is still a valid one : the signed areas of
+ *  the faces add up to zero, so the outer face can not be ccw too. The
+ *  edges and the link edges of the star are put in EDGES on the way. */
+static int starOrientation(DelaunaySubdivision *sub, Edge::Ptr e0, vector<Edge::Ptr> &edges) {
+	const int v = e0->org();
+	int ret = 1;
+	Edge::Ptr e = e0;
+	do {
+		Edge::Ptr n = e->Lnext(), o = e->Onext();
+		const int b = o->dest();
+		if (n->dest() != b) ret = 0;
+		else if (!sub->CCW(v, e->dest(), b)) return -1;
+		edges.push_back(e);
+		edges.push_back(n);
+		e = o;
+	} while (e != e0);
+	return ret;
+}
+
+
+/** Moves the vertex V to TO, in a Delaunay triangulation, and keeps it
+ *  Delaunay. If all the triangles around V stay ccw, its star is kept,
+ *  and its edges and link edges are flipped by a Lawson pass. Else V is
+ *  removed and inserted again, starting the search at a neighbour.
+ *  Returns 0 if V was moved in its star, 1 if it was inserted again, and
+ *  -1 if it could not be : TO is on another vertex (V is left out, as a
+ *  duplicate), or V has a constrained edge. */
+int DelaunaySubdivision::moveSite(int v, const Vector2d &to) {
+	Edge::Ptr e0 = siteEdge(v), e = e0;
+	Vector2dPtr p = point_ptrs[v];
+	const Vector2d at = *p;
+	*p = to;
+	vector<Edge::Ptr> stack;
+	if (starOrientation(this, e0, stack) > 0) {
+		lawsonFlip(stack);
+		return 0;
+	}
+	*p = at;
+	do {
+		if (e->qEdge()->constrained) return -1;
+		e = e->Onext();
+	} while (e != e0);
+
+	const int w = e0->dest();
+	removeSite(v);
+	*p = to;
+	if (insertSiteIndex(v, p, siteEdge(w))->org() != v) {
+		point_ptrs[v] = p; // still a site, in points, but not a vertex.
+		return -1;
+	}
+	points.pop_back(); // V was in points already.
+	return 1;
+}
+
+
+/** Moves the sites, and repairs the triangulation by flips. Only the stars
+ *  of the sites which moved are looked at : site_edges leads to them, and
+ *  swap and deleteEdge keep it valid from one call to the next.
+ *
+ *  A site whose triangles all stay ccw is moved at once, in its star : the
+ *  triangulation stays valid. One Lawson pass over the edges of these stars
+ *  and their links, each seen once, then makes it Delaunay. The other sites
+ *  (one of their triangles turned over, or on the hull) are moved after
+ *  that by moveSite, one at a time. */
+bool DelaunaySubdivision::updateCoordinates(const RowMatrixXd &positions,
+		double max_inverted, bool time) {
+	if (!randEdge) {
+		cout << "Moving sites : compute the triangulation first. Exiting.\n";
+		exit(-1);
+	}
+	if (!weights.empty()) {
+		cout << "Moving sites : not supported on a regular triangulation. Exiting.\n";
+		exit(-1);
+	}
+	if (positions.rows() != point_ptrs.size() || positions.cols() != 2) {
+		cout << "Moving sites : expecting "<<point_ptrs.size()<<" x 2 positions, found "
+			 <<positions.rows()<<" x "<<positions.cols()<<". Exiting.\n";
+		exit(-1);
+	}
+	double tim = wallTime();
+	if (site_edges.size() != point_ptrs.size()) indexSites();
+
+	// the sites which move. A site left out as a duplicate may not be one
+	// once it has moved.
+	vector<int> moved;
+	bool all_in = true;
+	int vertices = 0;
+	for (int v = 0; v < point_ptrs.size(); v += 1) {
+		if (!point_ptrs[v]) continue;
+		if (point_ptrs[v]->x() != positions(v,0) || point_ptrs[v]->y() != positions(v,1))
+			moved.push_back(v);
+		if (site_edges[v]) vertices += 1;
+		else               all_in = false;
+	}
+
+	// the outer face, found while the old coordinates are still there :
+	// the leftmost site is on it.
+	Edge::Ptr outer;
+	if (hull_edge && hull_edge->qEdge() && !leftFaceIsTriangle(hull_edge->Sym()))
+		outer = hull_edge->Sym();
+	if (!outer && all_in) {
+		int left = -1;
+		for (int v = 0; v < point_ptrs.size(); v += 1) {
+			if (!point_ptrs[v]) continue;
+			const Vector2d &p = *point_ptrs[v];
+			if (left < 0 || p.x() < point_ptrs[left]->x()
+					|| (p.x() == point_ptrs[left]->x() && p.y() < point_ptrs[left]->y())) left = v;
+		}
+		Edge::Ptr e = siteEdge(left), f = e;
+		do {
+			if (!leftFaceIsTriangle(f)) outer = f;
+			f = f->Onext();
+		} while (!outer && f != e);
+	}
+	const bool flat = !outer || !leftFaceIsTriangle(outer->Sym());
+
+	// 2V - H - 2 triangles, for H sites on the hull.
+	int triangles = 0;
+	if (!flat) {
+		triangles = 2*vertices - 2;
+		Edge::Ptr h = outer;
+		do {
+			triangles -= 1;
+			h = h->Lnext();
+		} while (h != outer);
+	}
+
+	// the sites which stay in their stars, and the edges to check. The
+	// stars are visited along a Hilbert curve, for the caches.
+	if (moved.size() > 1) hilbertSort(moved, &point_ptrs, 0, moved.size()-1);
+	bool repaired = !flat && all_in;
+	vector<int> hard;
+	vector<Edge::Ptr> star, stack;
+	int turned = 0;
+	for (int i = 0; i < moved.size() && repaired; i += 1) {
+		const int v = moved[i];
+		const Vector2d at = *point_ptrs[v];
+		*point_ptrs[v] = Vector2d(positions(v,0), positions(v,1));
+		star.clear();
+		const int o = starOrientation(this, siteEdge(v), star);
+		if (o <= 0) {
+			*point_ptrs[v] = at;
+			hard.push_back(v);
+			if (o < 0) turned += 1;
+			repaired = turned <= max_inverted * triangles;
+			continue;
+		}
+		for (int k = 0; k < star.size(); k += 1) {
+			QuadEdge::Ptr q = star[k]->qEdge();
+			if (q->visit_num) continue;
+			q->visit_num = 1;
+			stack.push_back(star[k]);
+		}
+	}
+	// the writers use the marks too.
+	for (int i = 0; i < stack.size(); i += 1) stack[i]->qEdge()->visit_num = 0;
+	if (repaired) lawsonFlip(stack);
+
+	int reinserted = 0;
+	for (int i = 0; i < hard.size() && repaired; i += 1) {
+		const int v = hard[i];
+		const int r = moveSite(v, Vector2d(positions(v,0), positions(v,1)));
+		repaired = (r >= 0);
+		reinserted += r;
+	}
+
+	if (!repaired) {
+		// too far gone : triangulate again.
+		for (int i = 0; i < moved.size(); i += 1) {
+			const int v = moved[i];
+			*point_ptrs[v] = Vector2d(positions(v,0), positions(v,1));
+		}
+		clearSubdivision();
+		computeDelaunay(INCREMENTAL);
+		if (segments.size()) insertSegments();
+	}
+
+	if (time) {
+		cout <<">>> "<<wallTime()-tim<<" seconds to move "<<moved.size()<<" sites : "<<turned
+			 <<" turn a triangle over, of "<<triangles<<" triangles, ";
+		if (repaired) cout <<"repaired by flips, "<<reinserted<<" sites inserted again.\n";
+		else          cout <<"triangulated again.\n";
+	}
+	return repaired;
+}
+
+
+/** Thread entry for locateAll : locates the queries ORDER[start, end)
+ *  one after the other, each walk starting at the previous answer.
+ *  The walks only read the subdivision. */
+void DelaunaySubdivision::locateRange(const std::vector<Vector2dPtr> *ptrs,
+		const std::vector<int> *order, int start, int end, std::vector<Edge::Ptr> *result) {
+	Edge::Ptr e = randEdge->edges[0];
+	for (int i = start; i < end; i += 1) {
+		const int q = (*order)[i];
+		e = locate(*(*ptrs)[q], e);
+		(*result)[q] = e;
+	}
+}
+
+
+/** Batch point location on the finished triangulation.*/
+void DelaunaySubdivision::locateAll(const std::vector<int> &ids, const std::vector<Vector2dPtr> &ptrs,
+		std::vector<Edge::Ptr> &result, bool time) {
+	if (!randEdge) {
+		cout << "Point location : compute the triangulation first. Exiting.\n";
+		exit(-1);
+	}
+	double tim = wallTime();
+	const int Q = ids.size();
+
+	// sort positions into IDS, so that the answers land in ids order.
+	vector<Vector2dPtr> qptrs(Q);
+	vector<int> order(Q);
+	for (int i = 0; i < Q; i += 1) {
+		qptrs[i] = ptrs[ids[i]];
+		order[i] = i;
+	}
+	hilbertSort(order, &qptrs, 0, Q-1);
+	result.assign(Q, Edge::Ptr());
+
+	initPredicates();
+	const int T = std::max(1, std::min(num_threads, Q/4096));
+	boost::thread_group workers;
+	for (int t = 1; t < T; t += 1)
+		workers.create_thread(boost::bind(&DelaunaySubdivision::locateRange, this,
+				&qptrs, &order, (int) ((long) Q*t/T), (int) ((long) Q*(t+1)/T), &result));
+	locateRange(&qptrs, &order, 0, Q/T, &result);
+	workers.join_all();
+
+	if (time) {
+		tim = wallTime() - tim;
+		cout <<">>> located "<<Q<<" points in "<<tim<<" seconds ("<<Q/tim
+			 <<" queries/s, "<<T<<" threads).\n";
+	}
+}
+
+
+/** Anglada's [1997] re-triangulation of the cavity left of BASE, after the
+ *  edges crossed by the segment BASE have been deleted. The vertex c of
+ *  the face whose circle with BASE is empty of the other vertices makes
+ *  the Delaunay triangle on BASE; the two pieces of the face on either
+ *  side of it are done in turn. */
+void DelaunaySubdivision::triangulateCavity(Edge::Ptr base) {
+	vector<Edge::Ptr> stack(1, base);
+	while (!stack.empty()) {
+		base = stack.back();
+		stack.pop_back();
+		const int a = base->org(), b = base->dest();
+		if (base->Lnext()->Lnext()->dest() == a) continue; // a triangle
+
+		// in : the face edge into c.
+		Edge::Ptr in = base->Lnext();
+		for (Edge::Ptr f = in->Lnext(); f->dest() != a; f = f->Lnext())
+			if (INCIRCLE(a, b, in->dest(), f->dest())) in = f;
+
+		Edge::Ptr ca = in->Lnext();
+		if (ca->dest() != a) {
+			ca = connect(in, base);
+			stack.push_back(ca->Sym());
+		}
+		if (in != base->Lnext())
+			stack.push_back(connect(base, ca)->Sym());
+	}
+}
+
+
+/** Inserts the segment A-B as a constrained edge : the edges it crosses
+ *  are deleted, and the cavities on its two sides are re-triangulated.
+ *  The walk from A to B is O(k) for k crossed edges. A segment through
+ *  other vertices is split at them. */
+bool DelaunaySubdivision::insertSegment(int a, int b) {
+	if (site_edges.size() != point_ptrs.size()) indexSites();
+	if (!siteEdge(a) || !siteEdge(b)) indexSites();
+	Edge::Ptr e = siteEdge(a);
+	if (a == b || !e || !siteEdge(b)) {
+		cout << ">>> Segment ("<<a<<", "<<b<<") does not join two vertices. Skipping.\n";
+		return false;
+	}
+	const Vector2d pb = *point_ptrs[b];
+
+	while (a != b) {
+		// the edge out of A along the segment, or the triangle it leaves A through.
+		Edge::Ptr f = e;
+		bool found = false, wedge = false;
+		do {
+			const int p = f->dest();
+			const Vector2d d = *point_ptrs[p] - *point_ptrs[a];
+			if (p == b || (orient2d(*point_ptrs[a], *point_ptrs[p], pb) == 0.0
+					&& d.dot(pb - *point_ptrs[a]) > 0.0)) {
+				// an edge of the segment : continue from its other end.
+				f->qEdge()->constrained = true;
+				a = p;
+				e = f->Sym();
+				found = true;
+				break;
+			}
+			if (leftFaceIsTriangle(f) && leftOf(b, f) && rightOf(b, f->Onext())) {
+				wedge = true;
+				break;
+			}
+			f = f->Onext();
+		} while (f != e);
+		if (found) continue;
+		if (!wedge) {
+			cout << ">>> Segment ("<<a<<", "<<b<<") : no triangle out of "<<a<<". Skipping.\n";
+			return false;
+		}
+
+		// walk to B (or to a vertex on the segment), collecting the crossed edges,
+		// each directed from the right of the segment to its left.
+		vector<Edge::Ptr> crossed;
+		Edge::Ptr s = f->Lnext();
+		Edge::Ptr e1 = f->Lprev(), e2; // into A, and out of the end, on the left side
+		int c;
+		while (true) {
+			if (s->qEdge()->constrained) {
+				cout << ">>> Segment ("<<a<<", "<<b<<") crosses another segment. Skipping.\n";
+				return false;
+			}
+			crossed.push_back(s);
+			Edge::Ptr t = s->Sym();
+			const int r = t->Lnext()->dest();
+			if      (r != b && CCW(a, b, r)) s = t->Lnext();
+			else if (r != b && CCW(b, a, r)) s = t->Lprev();
+			else {
+				c  = r;
+				e2 = t->Lprev();
+				break;
+			}
+		}
+
+		for (int i = 0; i < crossed.size(); i += 1) deleteEdge(crossed[i]);
+		Edge::Ptr ac = connect(e1, e2);
+		ac->qEdge()->constrained = true;
+
+		// the edges of the two cavities stay : point their origins at them.
+		Edge::Ptr sides[2] = {ac, ac->Sym()};
+		for (int k = 0; k < 2; k += 1) {
+			Edge::Ptr g = sides[k];
+			do {
+				site_edges[g->org()] = g;
+				g = g->Lnext();
+			} while (g != sides[k]);
+		}
+		triangulateCavity(ac);
+		triangulateCavity(ac->Sym());
+		randEdge = ac->qEdge();
+
+		a = c;
+		e = ac->Sym();
+	}
+	return true;
+}
+
+
+/** Inserts all the segments read from the .poly file. */
+void DelaunaySubdivision::insertSegments(bool time) {
+	double tim = wallTime();
+	int n = 0;
+	for (int i = 0; i < segments.size(); i += 1)
+		n += insertSegment(segments[i].first, segments[i].second);
+	if (time) {
+		tim = wallTime() - tim;
+		cout <<">>> "<<tim<<" seconds to insert "<<n<<" of "<<segments.size()<<" segments.\n";
+	}
+}
+
+
+/** Is the vertex P strictly inside the diametral circle of the edge S? */
+bool DelaunaySubdivision::encroaches(int p, Edge::Ptr s) {
+	const Vector2d &x = *point_ptrs[p];
+	return (*point_ptrs[s->org()] - x).dot(*point_ptrs[s->dest()] - x) < 0.0;
+}
+
+
+/** Is the constrained edge S encroached by the apex of a triangle beside it?
+ *  In a constrained Delaunay triangulation, an encroaching vertex is
+ *  always one of these two. */
+bool DelaunaySubdivision::isEncroached(Edge::Ptr s) {
+	return (leftFaceIsTriangle(s) && encroaches(s->Lnext()->dest(), s))
+		|| (leftFaceIsTriangle(s->Sym()) && encroaches(s->Sym()->Lnext()->dest(), s));
+}
+
+
+/** Straight walk from the triangle left of T towards the point C.
+ *  Returns an edge of the triangle containing C, or, if the walk would
+ *  cross a constrained edge first, that edge in CROSSED. */
+Edge::Ptr DelaunaySubdivision::walkToward(Edge::Ptr t, const Eigen::Vector2d &c, Edge::Ptr &crossed) {
+	crossed.reset();
+	const Vector2d g = (*point_ptrs[t->org()] + *point_ptrs[t->dest()]
+			+ *point_ptrs[t->Lnext()->dest()]) / 3.0;
+
+	// the edge where the line g->c leaves the first triangle ahead of g :
+	// ccw around g, its origin is right of the line and its destination is not.
+	Edge::Ptr s = t;
+	for (int i = 0; i < 3; i += 1, s = s->Lnext())
+		if (orient2d(g, c, *point_ptrs[s->org()]) < 0.0
+				&& orient2d(g, c, *point_ptrs[s->dest()]) >= 0.0) break;
+
+	while (true) {
+		if (orient2d(*point_ptrs[s->org()], *point_ptrs[s->dest()], c) >= 0.0)
+			return s; // C is not beyond s
+		if (s->qEdge()->constrained) {
+			crossed = s;
+			return Edge::Ptr();
+		}
+		Edge::Ptr u = s->Sym();
+		const int r = u->Lnext()->dest();
+		s = (orient2d(g, c, *point_ptrs[r]) >= 0.0)? u->Lnext() : u->Lprev();
+	}
+}
+
+
+/** Splits the constrained edge S, and returns the new site. If just one
+ *  end is an input vertex (index below N_INPUT), the split is on the circle
+ *  about it whose radius is the power of two nearest to half the edge :
+ *  Ruppert's concentric shells. Segments meeting at a small angle are then
+ *  split at the same distances, and stop encroaching on each other.
+ *  Else the split is at the midpoint. */
+int DelaunaySubdivision::splitSegment(Edge::Ptr s, RefineState &q) {
+	if (!leftFaceIsTriangle(s)) s = s->Sym();
+	const int n_input = q.n_input;
+	const Vector2d &a = *point_ptrs[s->org()], &b = *point_ptrs[s->dest()];
+	double t = 0.5;
+	if ((s->org() < n_input) != (s->dest() < n_input)) {
+		const double len = (b - a).norm();
+		const double r = std::pow(2.0, std::floor(std::log(0.5*len)/std::log(2.0) + 0.5));
+		t = (s->org() < n_input)? r/len : 1.0 - r/len;
+		if (t < 0.25 || t > 0.75) t = 0.5;
+	}
+	std::pair<int,int> seg(s->org(), s->dest());
+	if (s->org() >= n_input && q.on_segment[s->org() - n_input].first >= 0)
+		seg = q.on_segment[s->org() - n_input];
+	else if (s->dest() >= n_input && q.on_segment[s->dest() - n_input].first >= 0)
+		seg = q.on_segment[s->dest() - n_input];
+
+	const int id = point_ptrs.size();
+	point_ptrs.push_back(Vector2dPtr(new Vector2d(a + t*(b - a))));
+	points.push_back(id);
+	site_edges.resize(point_ptrs.size());
+	q.on_segment.resize(id - n_input + 1);
+	q.on_segment.back() = seg;
+
+	Edge::Ptr e = connectInside(id, s, true);
+	randEdge = e->qEdge();
+	refreshRing(e);
+	return id;
+}
+
+
+/** Queues the bad triangles around the site V, and its encroached segments :
+ *  the constrained edges out of V and across its triangles. */
+void DelaunaySubdivision::queueAround(int v, RefineState &q) {
+	Edge::Ptr e = siteEdge(v), f = e;
+	do {
+		if (f->qEdge()->constrained && isEncroached(f)) q.segs.push_back(f);
+		if (leftFaceIsTriangle(f)) {
+			Edge::Ptr g = f->Lnext();
+			if (g->qEdge()->constrained && isEncroached(g)) q.segs.push_back(g);
+			queueTriangle(f, q);
+		}
+		f = f->Onext();
+	} while (f != e);
+}
+
+
+/** True if the Steiner sites P and R split two input segments which meet
+ *  at an angle below 60 degrees. */
+bool DelaunaySubdivision::acrossInputAngle(int p, int r, const RefineState &q) {
+	if (p < q.n_input || r < q.n_input) return false;
+	std::pair<int,int> s = q.on_segment[p - q.n_input], t = q.on_segment[r - q.n_input];
+	if (s.first < 0 || t.first < 0) return false;
+	if (s.first == t.second) std::swap(t.first, t.second);
+	if (s.second == t.first) std::swap(s.first, s.second);
+	if (s.second == t.second) { std::swap(s.first, s.second); std::swap(t.first, t.second); }
+	if (s.first != t.first || s.second == t.second) return false;
+
+	const Vector2d &v = *point_ptrs[s.first];
+	const Vector2d a = *point_ptrs[s.second] - v, b = *point_ptrs[t.second] - v;
+	return a.dot(b) > 0.5 * a.norm() * b.norm();
+}
+
+
+/** Queues the triangle left of E if its circumradius to shortest edge ratio
+ *  is above the bound, or its area above the maximum. The smallest angle
+ *  does not count if it is between two segments at an input vertex, or if
+ *  the shortest edge is across such an angle (Shewchuk 2002, section 4) :
+ *  no Steiner point can make it larger, and splitting it never ends. */
+void DelaunaySubdivision::queueTriangle(Edge::Ptr e, RefineState &q) {
+	BadTriangle t;
+	t.e = e;
+	t.v[0] = e->org(); t.v[1] = e->dest(); t.v[2] = e->Lnext()->dest();
+	const Vector2d &a = *point_ptrs[t.v[0]], &b = *point_ptrs[t.v[1]], &c = *point_ptrs[t.v[2]];
+	const double l[3] = {(c-b).squaredNorm(), (a-c).squaredNorm(), (b-a).squaredNorm()};
+	const int k = (l[0] <= l[1] && l[0] <= l[2])? 0 : ((l[1] <= l[2])? 1 : 2);
+	const Vector2d cc = circumcenter(a, b, c);
+	t.ratio = std::sqrt((cc - a).squaredNorm() / l[k]);
+
+	// the two edges at the vertex k, opposite the shortest edge.
+	Edge::Ptr at_k = (k == 0)? e : ((k == 1)? e->Lnext() : e->Lprev());
+	const bool input_angle = (t.v[k] < q.n_input && at_k->qEdge()->constrained
+			&& at_k->Lprev()->qEdge()->constrained)
+			|| acrossInputAngle(t.v[(k+1)%3], t.v[(k+2)%3], q);
+	if ((t.ratio > q.bound && !input_angle)
+			|| (q.max_area > 0.0 && 0.5*orient2d(a, b, c) > q.max_area))
+		q.bad.push(t);
+}
+
+
+/** Ruppert's Delaunay refinement, with Shewchuk's [1997] ordering :
+ *  encroached segments are split first; then the worst triangle gets its
+ *  circumcenter, unless that encroaches a segment, which is split instead.
+ *  All the sites go in by incremental insertion. */
+int DelaunaySubdivision::refine(double min_angle, double max_area, int max_steiner, bool time) {
+	double tim = wallTime(), tim_segs = 0.0, tim_tris = 0.0;
+	const int n_start = point_ptrs.size();
+	RefineState q;
+	q.bound    = 1.0 / (2.0 * std::sin(min_angle * M_PI / 180.0));
+	q.max_area = max_area;
+	q.n_input  = n_start;
+
+	// the hull bounds the domain : its edges are segments.
+	vector<QuadEdge::Ptr> qedges;
+	collectQuadEdges(qedges);
+	for (int i = 0; i < qedges.size(); i += 1) {
+		Edge::Ptr e = qedges[i]->edges[0];
+		if (!leftFaceIsTriangle(e) || !leftFaceIsTriangle(e->Sym()))
+			qedges[i]->constrained = true;
+	}
+	for (int i = 0; i < qedges.size(); i += 1) {
+		Edge::Ptr e = qedges[i]->edges[0];
+		for (int k = 0; k < 2; k += 1, e = e->Sym())
+			if (leftFaceIsTriangle(e) && e->org() < e->dest() && e->org() < e->Lnext()->dest())
+				queueTriangle(e, q);
+	}
+	for (int i = 0; i < qedges.size(); i += 1)
+		if (qedges[i]->constrained && isEncroached(qedges[i]->edges[0]))
+			q.segs.push_back(qedges[i]->edges[0]);
+	qedges.clear();
+	indexSites();
+	const int n_bad = q.bad.size();
+	const double tim_setup = wallTime() - tim;
+
+	int n_splits = 0, n_centers = 0, n_rejected = 0, n_stale = 0;
+	while (max_steiner < 0 || point_ptrs.size() - n_start < max_steiner) {
+		double t0 = wallTime();
+		if (!q.segs.empty()) {
+			Edge::Ptr s = q.segs.back();
+			q.segs.pop_back();
+			if (!s->qEdge() || !isEncroached(s)) continue;
+			queueAround(splitSegment(s, q), q);
+			n_splits += 1;
+			tim_segs += wallTime() - t0;
+			continue;
+		}
+		if (q.bad.empty()) break;
+
+		BadTriangle t = q.bad.top();
+		q.bad.pop();
+		Edge::Ptr e = t.e;
+		if (!e->qEdge() || e->org() != t.v[0] || e->dest() != t.v[1]) {
+			// removeSite may have made the triangle again, with new edges.
+			e.reset();
+			Edge::Ptr f = siteEdge(t.v[0]), g = f;
+			if (f) do {
+				if (g->dest() == t.v[1]) e = g;
+				g = g->Onext();
+			} while (g != f && !e);
+			t.e = e;
+		}
+		if (!e || e->Lnext()->dest() != t.v[2] || !leftFaceIsTriangle(e)) {
+			// the triangle was split since it was queued.
+			n_stale  += 1;
+			tim_tris += wallTime() - t0;
+			continue;
+		}
+
+		const Vector2d c = circumcenter(*point_ptrs[t.v[0]], *point_ptrs[t.v[1]], *point_ptrs[t.v[2]]);
+		Edge::Ptr crossed;
+		Edge::Ptr in = walkToward(e, c, crossed);
+		if (crossed) {
+			// C is across a segment : split it, and come back to the triangle.
+			queueAround(splitSegment(crossed, q), q);
+			q.bad.push(t);
+			n_splits += 1;
+			tim_segs += wallTime() - t0;
+			continue;
+		}
+
+		const int id = point_ptrs.size();
+		point_ptrs.push_back(Vector2dPtr(new Vector2d(c)));
+		points.push_back(id);
+		site_edges.resize(point_ptrs.size());
+		q.on_segment.resize(id - n_start + 1);
+		q.on_segment.back() = std::make_pair(-1, -1);
+		Edge::Ptr x = insertPoint(id, in);
+		if (x->org() != id) {
+			// C is already a site.
+			points.pop_back(); point_ptrs.pop_back(); site_edges.pop_back();
+			tim_tris += wallTime() - t0;
+			continue;
+		}
+		randEdge = x->qEdge();
+		refreshRing(x);
+
+		// a circumcenter which encroaches segments is taken out again.
+		vector<Edge::Ptr> hit;
+		Edge::Ptr f = x;
+		do {
+			Edge::Ptr g = f->Lnext();
+			if (leftFaceIsTriangle(f) && g->qEdge()->constrained && encroaches(id, g))
+				hit.push_back(g);
+			f = f->Onext();
+		} while (f != x);
+		if (hit.size()) {
+			// the edges across the star of C stay : split them instead.
+			removeSite(id);
+			points.pop_back(); point_ptrs.pop_back(); site_edges.pop_back();
+			for (int i = 0; i < hit.size(); i += 1)
+				queueAround(splitSegment(hit[i], q), q);
+			q.bad.push(t);
+			n_splits   += hit.size();
+			n_rejected += 1;
+		} else {
+			queueAround(id, q);
+			n_centers += 1;
+		}
+		tim_tris += wallTime() - t0;
+	}
+
+	if (time) {
+		cout <<">>> refine : "<<tim_setup<<" seconds to queue "<<n_bad<<" bad triangles.\n"
+			 <<">>> refine : "<<n_splits<<" segment splits in "<<tim_segs<<" seconds.\n"
+			 <<">>> refine : "<<n_centers<<" circumcenters in "<<tim_tris<<" seconds ("
+			 <<n_rejected<<" taken out for encroaching, "<<n_stale<<" stale triangles).\n"
+			 <<">>> "<<wallTime()-tim<<" seconds to refine : "<<point_ptrs.size()-n_start<<" Steiner points.\n";
+	}
+	return point_ptrs.size() - n_start;
+}
+
+
+/** The convex hull, walking the outer face from hull_edge. */
+void DelaunaySubdivision::convexHull(std::vector<int> &hull) {
+	hull.clear();
+	if (!randEdge) return;
+
+	// the handle is stale if its edge was deleted, or is no longer on the hull.
+	if (!hull_edge || !hull_edge->qEdge() || leftFaceIsTriangle(hull_edge->Sym())) {
+		double x_min = HUGE_VAL;
+		for (int i = 0; i < points.size(); i += 1)
+			if (point_ptrs[points[i]]) x_min = std::min(x_min, point_ptrs[points[i]]->x());
+		Edge::Ptr start = randEdge->edges[0];
+		const Vector2d x(x_min - 1 - fabs(x_min), point_ptrs[start->org()]->y());
+		// the walk ends on a hull edge with the outer face to its left.
+		hull_edge = locate(x, start)->Sym();
+	}
+
+	// Rnext goes around the outer face backwards : fill from the end.
+	vector<int> ring;
+	Edge::Ptr e = hull_edge;
+	do {
+		ring.push_back(e->org());
+		e = e->Rnext();
+	} while (e != hull_edge);
+	std::reverse(ring.begin(), ring.end());
+
+	const int H = ring.size();
+	for (int i = 0; i < H; i += 1)
+		if (CCW(ring[(i+H-1)%H], ring[i], ring[(i+1)%H]))
+			hull.push_back(ring[i]);
+
+	if (hull.size() < 3) {
+		// collinear sites : the walk went out and back along the line.
+		hull.clear();
+		int lo = ring[0], hi = ring[0];
+		PtrCoordinateComparator less(2, 0);
+		for (int i = 1; i < H; i += 1) {
+			if (less(point_ptrs[ring[i]], point_ptrs[lo])) lo = ring[i];
+			if (less(point_ptrs[hi], point_ptrs[ring[i]])) hi = ring[i];
+		}
+		hull.push_back(lo);
+		if (hi != lo) hull.push_back(hi);
+	}
+}
+
+
+/** Andrew's monotone chain : the lower hull left to right,
+ *  then the upper hull right to left. */
+void DelaunaySubdivision::monotoneChainHull(std::vector<int> &hull) {
+	vector<int> sorted;
+	for (int i = 0; i < points.size(); i += 1)
+		if (point_ptrs[points[i]]) sorted.push_back(points[i]);
+	hull.clear();
+	const int N = sorted.size();
+	if (N == 0) return;
+	lexicoSort(sorted, &point_ptrs, 0, N-1);
+
+	hull.resize(2*N);
+	int k = 0;
+	for (int i = 0; i < N; i += 1) {
+		while (k >= 2 && !CCW(hull[k-2], hull[k-1], sorted[i])) k -= 1;
+		hull[k++] = sorted[i];
+	}
+	for (int i = N-2, lower = k+1; i >= 0; i -= 1) {
+		while (k >= lower && !CCW(hull[k-2], hull[k-1], sorted[i])) k -= 1;
+		hull[k++] = sorted[i];
+	}
+	// the first point closes the chain.
+	hull.resize(std::max(1, k-1));
+	if (hull.size() == 2 && *point_ptrs[hull[0]] == *point_ptrs[hull[1]])
+		hull.resize(1);
+}
+
+
+/** Each triangle once : from the quad-edge of its ccw edge out of its
+ *  smallest vertex. */
+void DelaunaySubdivision::triangles(std::vector<int> &tris) {
+	vector<QuadEdge::Ptr> qedges;
+	collectQuadEdges(qedges);
+	for (int i = 0; i < qedges.size(); i += 1) {
+		Edge::Ptr e = qedges[i]->edges[0];
+		const int a = e->org(), b = e->dest();
+		if (a < b) { // the left triangle, if a is its smallest vertex
+			const int l = e->Onext()->dest();
+			if (a < l && CCW(a, b, l)) {
+				tris.push_back(a); tris.push_back(b); tris.push_back(l);
+			}
+		} else {     // the right one, if b is
+			const int r = e->Oprev()->dest();
+			if (b < r && CCW(b, a, r)) {
+				tris.push_back(b); tris.push_back(a); tris.push_back(r);
+			}
+		}
+	}
+}
+
+
+/** The triangles, with their neighbours : the two sides of an edge have the
+ *  same key, (smaller end, larger end), and are next to each other once
+ *  the keys are radix sorted. */
+void DelaunaySubdivision::triangleMesh(std::vector<int> &tris, std::vector<int> &nbrs) {
+	tris.clear();
+	triangles(tris);
+	const int H = tris.size(); // sides : side 3t+k is (v_k, v_k+1) of triangle t
+	vector<uint64_t> keys(H);
+	vector<int> sides(H);
+	for (int h = 0; h < H; h += 1) {
+		const uint64_t a = tris[h], b = tris[h - h%3 + (h%3 + 1)%3];
+		keys[h]  = (a < b)? (a << 32 | b) : (b << 32 | a);
+		sides[h] = h;
+	}
+	radixSort(keys, sides);
+	nbrs.assign(H, -1);
+	for (int i = 0; i+1 < H; i += 1) {
+		if (keys[i] != keys[i+1]) continue;
+		nbrs[sides[i]]   = sides[i+1] / 3;
+		nbrs[sides[i+1]] = sides[i] / 3;
+		i += 1;
+	}
+}
+
+
+/** Numbers the triangles and fills the dual vertices and voronoi_vertices.*/
+int DelaunaySubdivision::computeVoronoi() {
+	vector<QuadEdge::Ptr> qedges;
+	return computeVoronoi(qedges);
+}
+
+
+int DelaunaySubdivision::computeVoronoi(vector<QuadEdge::Ptr> &qedges) {
+	qedges.clear();
+	collectQuadEdges(qedges);
+
+	// -2 : face not numbered yet.
+	for (int i = 0; i < qedges.size(); i += 1) {
+		qedges[i]->edges[1]->setOrg(-2);
+		qedges[i]->edges[3]->setOrg(-2);
+	}
+
+	vector<Edge::Ptr> firsts; // an edge of each triangle, by number
+	for (int i = 0; i < qedges.size(); i += 1) {
+		Edge::Ptr es[2] = {qedges[i]->edges[0], qedges[i]->edges[2]};
+		for (int k = 0; k < 2; k += 1) {
+			Edge::Ptr e = es[k];
+			Edge::Ptr d = e->RotInv();
+			if (d->org() != -2) continue;
+			// leftFaceIsTriangle, keeping the edges of the face.
+			Edge::Ptr n = d->Onext()->Rot();
+			Edge::Ptr p = n->Lnext();
+			if (p->Lnext() != e || !CCW(e->org(), e->dest(), n->dest())) {
+				d->setOrg(-1);
+				continue;
+			}
+			const int f = firsts.size();
+			d->setOrg(f);
+			n->RotInv()->setOrg(f);
+			p->RotInv()->setOrg(f);
+			firsts.push_back(e);
+		}
+	}
+
+	const int F = firsts.size();
+	voronoi_vertices.resize(F, 2);
+	for (int f = 0; f < F; f += 1) {
+		Edge::Ptr e = firsts[f];
+		voronoi_vertices.row(f) = circumcenter(*point_ptrs[e->org()], *point_ptrs[e->dest()],
+				*point_ptrs[e->Onext()->dest()]).transpose();
+	}
+	return F;
+}
+
+
+/** Clips the convex polygon POLY to the half-plane x[axis]*sign <= bound*sign
+ *  (Sutherland-Hodgman). */
+static void clipPolygon(vector<Vector2d, aligned_allocator<Vector2d> > &poly,
+		int axis, double bound, double sign) {
+	vector<Vector2d, aligned_allocator<Vector2d> > out;
+	const int K = poly.size();
+	for (int i = 0; i < K; i += 1) {
+		const Vector2d &a = poly[i], &b = poly[(i+1)%K];
+		const bool a_in = a[axis]*sign <= bound*sign;
+		const bool b_in = b[axis]*sign <= bound*sign;
+		if (a_in) out.push_back(a);
+		if (a_in != b_in) {
+			const double t = (bound - a[axis]) / (b[axis] - a[axis]);
+			out.push_back(a + t*(b - a));
+		}
+	}
+	poly.swap(out);
+}
+
+
+/** Voronoi cells of the sites, clipped to the box [LO, HI], as flat arrays.
+ *  The cell of a hull site is unbounded : its two rays, along the outward
+ *  normals of its hull edges, are cut far outside the box and joined
+ *  through a point on their bisector before clipping. */
+void DelaunaySubdivision::voronoiCells(const Eigen::Vector2d &lo, const Eigen::Vector2d &hi,
+		std::vector<int> &sites, std::vector<int> &offsets, std::vector<double> &coords) {
+	indexSites();
+	sites.clear(); offsets.assign(1, 0); coords.clear();
+
+	vector<Vector2d, aligned_allocator<Vector2d> > poly;
+	for (int i = 0; i < points.size(); i += 1) {
+		const int v = points[i];
+		if (!point_ptrs[v]) continue;
+		Edge::Ptr e0 = siteEdge(v);
+		if (!e0) continue; // a duplicate
+
+		// the faces around v, ccw, starting after the outer face.
+		Edge::Ptr start = e0, e = e0;
+		do {
+			if (e->RotInv()->org() < 0) start = e->Onext();
+			e = e->Onext();
+		} while (e != e0);
+
+		poly.clear();
+		e = start;
+		do {
+			if (e->RotInv()->org() >= 0)
+				poly.push_back(voronoi_vertices.row(e->RotInv()->org()).transpose());
+			e = e->Onext();
+		} while (e != start);
+		if (poly.empty()) continue; // no triangle at all
+
+		const int hull_edge = start->Oprev()->RotInv()->org();
+		if (hull_edge < 0) {
+			// start->Oprev() has the outer face on its left, start on its right.
+			const Vector2d &pv = *point_ptrs[v];
+			const Vector2d d1 = *point_ptrs[start->Oprev()->dest()] - pv;
+			const Vector2d d0 = *point_ptrs[start->dest()] - pv;
+			const Vector2d n1(-d1.y(), d1.x());  // left of start->Oprev()
+			const Vector2d n0(d0.y(), -d0.x());  // right of start
+			const double L = 4.0 * ((hi - lo).norm() + (pv - lo).norm() + (pv - hi).norm());
+			const Vector2d a = poly.back()  + L*n1.normalized();
+			const Vector2d c = poly.front() + L*n0.normalized();
+			const Vector2d m = pv + L*(n0.normalized() + n1.normalized()).normalized();
+			poly.push_back(a);
+			poly.push_back(m);
+			poly.push_back(c);
+		}
+
+		for (int axis = 0; axis < 2; axis += 1) {
+			clipPolygon(poly, axis, hi[axis],  1.0);
+			clipPolygon(poly, axis, lo[axis], -1.0);
+		}
+		sites.push_back(v);
+		for (int j = 0; j < poly.size(); j += 1) {
+			coords.push_back(poly[j].x());
+			coords.push_back(poly[j].y());
+		}
+		offsets.push_back(coords.size()/2);
+	}
+}
+
+
+/** The engines which seed a triangle return a null edge on collinear
+ *  points : the divide-and-conquer handles them. */
+Edge::Ptr DelaunaySubdivision::collinearFallback() {
+	lexicoSort(points, &point_ptrs, 0, points.size()-1);
+	hull_edge = divideConquerVerticalCuts(0, points.size()-1).first;
+	return hull_edge;
+}
+
+
+/** Main interface function.*/
+void DelaunaySubdivision::computeDelaunay(CutsType t, bool time) {
+	double tim = wallTime();
+
+	// drop the sites deleted by removeSite.
+	int n = 0;
+	for (int i = 0; i < points.size(); i += 1)
+		if (point_ptrs[points[i]]) points[n++] = points[i];
+	points.resize(n);
+	weights.clear();
+	hidden.clear();
+	// swap and deleteEdge would keep it up to date : insertSite re-indexes.
+	site_edges.clear();
+
+	if (t==AUTO_CUTS) {
+		static const char *names[] = {"vertical cuts", "alternating cuts", "seam-first cuts",
+				"incremental", "dwyer cuts", "sweep-hull", "multi-process cuts"};
+		InputProfile p = probeInput();
+		t = chooseAlgorithm(p);
+		cout <<">>> input : "<<p.n<<" points, aspect "<<p.aspect<<(p.tall? " (tall)":" (wide)")
+			 <<", "<<p.duplicates<<" duplicates, "<<100*p.integral_frac<<"% integral coords, "
+			 <<100*p.empty_frac<<"% empty cells.\n";
+		cout <<">>> auto  : "<<names[t];
+		if (t==PARALLEL_CUTS) cout<<" on "<<num_threads<<" threads";
+		cout <<".\n";
+		if (p.integral_frac > 0.99)
+			cout <<">>> lattice input : expect the exact stages of the predicates.\n";
+	}
+
+	if (t==VERTICAL_CUTS) {
+		lexicoSort(points, &point_ptrs, 0, points.size()-1);
+		std::pair<Edge::Ptr, Edge::Ptr> cvx_handles = divideConquerVerticalCuts(0, points.size()-1);
+		randEdge = cvx_handles.first->qEdge();
+		hull_edge = cvx_handles.first;
+	} else if (t==INCREMENTAL || t==SWEEP_HULL || t==PARALLEL_CUTS) {
+		// no handles from the first two : convexHull finds a hull edge
+		// when it is asked for.
+		hull_edge.reset();
+		Edge::Ptr e;
+		if (t==INCREMENTAL)     e = incrementalDelaunay();
+		else if (t==SWEEP_HULL) e = sweepHullDelaunay();
+		else {
+			initPredicates();
+			e = hull_edge = dewallDelaunay();
+		}
+		if (!e) e = collinearFallback();
+		randEdge = e->qEdge();
+	} else if (t==PROCESS_CUTS) {
+		std::pair<Edge::Ptr, Edge::Ptr> cvx_handles = divideConquerProcesses(num_threads);
+		randEdge = cvx_handles.first->qEdge();
+		hull_edge = cvx_handles.first;
+	} else if (t==DWYER_CUTS) {
+		HullHandles cvx_handles = dwyerDelaunay();
+		randEdge = cvx_handles.min[0]->qEdge();
+		hull_edge = cvx_handles.min[0];
+	} else {
+		HullHandles cvx_handles = divideConquerAlternatingCuts(0, points.size()-1);
+		randEdge = cvx_handles.min[0]->qEdge();
+		hull_edge = cvx_handles.min[0];
+	}
+
+	if (time) {
+		tim = wallTime() - tim;
+		cout <<">>> "<<tim<< " seconds to compute the triangulation.\n";
+	}
+}
+
+/** Regular triangulation : the incremental insertion of computeDelaunay's
+ *  INCREMENTAL, with the weights set, which switches insertPoint and
+ *  flipAround to the power test. */
+void DelaunaySubdivision::computeRegular(int channel, bool time) {
+	if (channel < 0 || channel >= attributes.cols()) {
+		cout << "Regular triangulation : no vertex attribute "<<channel<<" for the weights. Exiting.\n";
+		exit(-1);
+	}
+	double tim = wallTime();
+
+	// drop the sites deleted by removeSite.
+	int n = 0;
+	for (int i = 0; i < points.size(); i += 1)
+		if (point_ptrs[points[i]]) points[n++] = points[i];
+	points.resize(n);
+
+	weights.assign(point_ptrs.size(), 0.0);
+	for (int i = 0; i < std::min<int>(attributes.rows(), weights.size()); i += 1)
+		weights[i] = attributes(i, channel);
+	hidden.clear();
+	site_edges.clear();
+
+	hull_edge.reset();
+	Edge::Ptr e = incrementalDelaunay();
+	if (!e) {
+		cout << "Regular triangulation : the sites are collinear. Exiting.\n";
+		exit(-1);
 	}
+	randEdge = e->qEdge();
 
 	if (time) {
-		tim = clock() - tim;
-		cout <<">>> "<<((double)tim)/CLOCKS_PER_SEC<< " seconds to compute the triangulation.\n";
+		tim = wallTime() - tim;
+		cout <<">>> "<<tim<< " seconds to compute the regular triangulation ("
+			 <<hidden.size()<<" hidden sites).\n";
 	}
 }
 
@@ -11,6 +11,8 @@
 #include "utils/geom_predicates.h"
 
 #include <utility>
+#include <queue>
+#include <boost/random/mersenne_twister.hpp>
 #include "QuadEdge.h"
 #include "Edge.h"
 #include "Data.h"
@@ -20,7 +22,62 @@
 /** The type of division used in divide-conquer algo. */
 enum CutsType {
 	VERTICAL_CUTS,
-	ALTERNATE_CUTS
+	ALTERNATE_CUTS,
+	PARALLEL_CUTS,
+	INCREMENTAL,
+	DWYER_CUTS,
+	SWEEP_HULL,
+	PROCESS_CUTS,
+	AUTO_CUTS
+};
+
+
+/** The extreme edges of the convex hull of a sub-triangulation.
+ *
+ *  min[i] : ccw hull edge (outer face on its right) out of the vertex
+ *           which is lexico-smallest when coordinate i is compared first.
+ *  max[i] : cw hull edge (outer face on its left) out of the vertex
+ *           which is lexico-largest when coordinate i is compared first.
+ *
+ *  Hence (min[0], max[0]) are the G&S handles for LEFT, RIGHT merges
+ *  and   (min[1], max[1]) are the handles for BOTTOM, TOP merges. */
+struct HullHandles {
+	Edge::Ptr min[2];
+	Edge::Ptr max[2];
+};
+
+
+/** A triangle waiting for refinement : the left face of E, whose
+ *  vertices were V when it was queued. Worst (largest) RATIO first. */
+struct BadTriangle {
+	double    ratio; // circumradius / shortest edge
+	int       v[3];
+	Edge::Ptr e;
+	bool operator<(const BadTriangle &o) const { return ratio < o.ratio; }
+};
+
+
+/** The work queues and the quality bounds of DelaunaySubdivision::refine. */
+struct RefineState {
+	double bound;     // circumradius / shortest edge above which a triangle is bad
+	double max_area;  // area above which a triangle is bad (if positive)
+	int    n_input;   // the sites below this index are input vertices
+	std::priority_queue<BadTriangle> bad;
+	std::vector<Edge::Ptr> segs; // encroached segments
+	std::vector<std::pair<int,int> > on_segment; // input segment of each Steiner site, or (-1,-1)
+};
+
+
+/** A cheap summary of the input point distribution.
+ *  Used to pick the algorithm when AUTO_CUTS is requested. */
+struct InputProfile {
+	int    n;             // number of points
+	double aspect;        // long / short side of the bounding box (>= 1)
+	bool   tall;          // is the bounding box taller than it is wide?
+	int    duplicates;    // number of points which repeat an earlier point
+	double integral_frac; // fraction of the sampled coordinates which are integers
+	double empty_frac;    // fraction of empty cells when the sample is bucketed
+	                      // at 4 points per cell : ~0.02 for uniform points.
 };
 
 
@@ -36,7 +93,8 @@ public:
 	// wrapper for CCW checks for pointer to points.
 	bool CCW(int a, int b, int c);
 
-	/** Wrapper for incircle (orient2d) function.*/
+	/** Wrapper for incircle (orient2d) function : the power test
+	 *  instead, once computeRegular has set the weights.*/
 	bool INCIRCLE(int a, int b, int c, int d);
 
 	// see page G&S page 113 for the following functions
@@ -64,11 +122,9 @@ public:
 	std::pair<Edge::Ptr, Edge::Ptr> rotate_handles(std::pair<Edge::Ptr, Edge::Ptr> handles);
 
 
-
-	/** Rotate the handles.
-	 *  First handle  (this is the TOP handle)    goes RIGHT,
-	 *  Second handle (this is the BOTTOM handle) goes LEFT. */
-	std::pair<Edge::Ptr, Edge::Ptr> unrotate_handles(std::pair<Edge::Ptr, Edge::Ptr> handles);
+	/** Returns all the four extreme hull edges, given the LEFT, RIGHT handles.
+	 *  Walks the hull : only meant for the (constant sized) base cases. */
+	HullHandles hullHandles(std::pair<Edge::Ptr, Edge::Ptr> handles);
 
 
 
@@ -79,10 +135,20 @@ public:
 	 *			handles should correspond to topmost, bottom-most points.
 	 *          (i.e. points in lexico-order but in (y,x) comparison order).
 	 *
-	 *  Returns the outer handles.*/
+	 *  Returns the outer handles.
+	 *  If LOWER/ UPPER are given, they are set to the lower and upper common
+	 *  tangents; both are directed from the second to the first triangulation.*/
 	std::pair<Edge::Ptr, Edge::Ptr>
 	mergeTriangulations(std::pair<Edge::Ptr, Edge::Ptr> first_hs,
-			std::pair<Edge::Ptr, Edge::Ptr> second_hs);
+			std::pair<Edge::Ptr, Edge::Ptr> second_hs,
+			Edge::Ptr *lower=NULL, Edge::Ptr *upper=NULL);
+
+
+	/** Merges triangulations separated along AXIS (0 : LEFT, RIGHT; 1 : BOTTOM, TOP)
+	 *  and returns all the four extreme hull edges of the merged triangulation.
+	 *  The extremes across the cut are read off the common tangents,
+	 *  so no walks along the hull are needed. */
+	HullHandles mergeHulls(const HullHandles &first, const HullHandles &second, int axis);
 
 	/** Adds a new edge connecting the destination of e1 to the origin of e2.
 	 *  Returns the first primal edge of the newly added quad-edge.*/
@@ -93,8 +159,102 @@ public:
 	void deleteEdge(Edge::Ptr e);
 
 
-	/** Flips the diagonal of the quadrilateral containing e. From G&S [pg. 104]. */
-	void swap(Edge::Ptr e); // NOT REQUIRED FOR DIVIDE-AND-CONQUER
+	/** Flips the diagonal of the quadrilateral containing e. From G&S [pg. 104].
+	 *  A constrained edge is not flipped : returns false. */
+	bool swap(Edge::Ptr e); // NOT REQUIRED FOR DIVIDE-AND-CONQUER
+
+
+	/** Is the left face of the edge e a (ccw) triangle?
+	 *  This is false for the outer face, i.e. to the left of cw hull edges. */
+	bool leftFaceIsTriangle(Edge::Ptr e);
+
+
+	/** Locates the point X by walking the triangulation from the edge START.
+	 *  Returns an edge e such that :
+	 *    - X is inside or on the triangle to the left of e, or
+	 *    - X is outside the convex hull : e is a hull edge with the outer
+	 *      face to its left and X strictly to its left.
+	 *  Needs at least one triangle in the subdivision. */
+	Edge::Ptr locate(const Eigen::Vector2d &x, Edge::Ptr start);
+
+
+	/** Inserts the point with index X into the triangulation,
+	 *  searching for it from the edge HINT. Based on G&S [pg. 120].
+	 *  Returns an edge whose origin is at X. If X duplicates a vertex
+	 *  already present, it is not inserted and an edge out of that vertex is returned.
+	 *  With weights, X is not inserted either if it is hidden by the triangle
+	 *  it lies in (its power test is not positive) : it goes to hidden and
+	 *  an edge of that triangle is returned.
+	 *  Needs at least one triangle in the subdivision. */
+	Edge::Ptr insertPoint(int x, Edge::Ptr hint);
+
+	/** X is at the position of the vertex at the origin of S. Returns S.
+	 *  With weights, the heavier of the two is kept : X takes over the edges
+	 *  out of the vertex, which is hidden, and the triangulation is flipped
+	 *  regular around it. */
+	Edge::Ptr coincide(int x, Edge::Ptr s);
+
+
+	/** Connects X, which lies outside the convex hull, to the hull edges visible from it.
+	 *  E is a visible hull edge (outer face to its left, X strictly to its left).
+	 *  The visible hull edges are pushed onto STACK.
+	 *  Returns an edge whose origin is at X. */
+	Edge::Ptr connectOutside(int x, Edge::Ptr e, std::vector<Edge::Ptr> &stack);
+
+	/** Connects X, which lies in the triangle to the left of E (or on E,
+	 *  with ON_EDGE), to the vertices around it and flips the new triangles
+	 *  Delaunay. Returns an edge whose origin is at X. */
+	Edge::Ptr connectInside(int x, Edge::Ptr e, bool on_edge);
+
+
+	/** Flips edges till all the triangles incident to the new point X are Delaunay.
+	 *  STACK holds the edges opposite to X (X to their left) which need to be checked.
+	 *  With weights, a non-convex quadrilateral is fixed by a 3-1 flip.
+	 *  Returns XE, an edge out of X, or, if a 3-1 flip deleted it, another. */
+	Edge::Ptr flipAround(int x, std::vector<Edge::Ptr> &stack, Edge::Ptr xe);
+
+	/** The 3-1 flip of Edelsbrunner and Shah [1996] : E is opposite to X
+	 *  and T = E->Oprev(), and the quadrilateral of X, E and T is reflex at
+	 *  an end V of E. If V has only the three neighbours of the quadrilateral,
+	 *  it is deleted with its edges and hidden (4-2 flip if it is flat, with
+	 *  four neighbours). The new link edges are pushed onto STACK. Returns an
+	 *  edge out of X, or NULL if V is kept. */
+	Edge::Ptr hideVertex(int x, Edge::Ptr e, Edge::Ptr t, std::vector<Edge::Ptr> &stack);
+
+
+	/** Lawson's flip algorithm : flips the edges in STACK (and the edges
+	 *  of the quadrilaterals they are flipped in) till they are locally Delaunay.
+	 *  Works on any triangulation of the convex hull. */
+	void lawsonFlip(std::vector<Edge::Ptr> &stack);
+
+	/** Moves the vertex V to TO and keeps the triangulation Delaunay, for
+	 *  updateCoordinates : by flips if the triangles around V stay ccw, else
+	 *  by removing V and inserting it again. Returns 0 or 1 in these cases,
+	 *  and -1 if V has a constrained edge, or lands on another vertex. */
+	int moveSite(int v, const Eigen::Vector2d &to);
+
+
+	/** Radial sweep-hull (s-hull) delaunay triangulation [Sinclair, 2010].
+	 *  Seeds a triangle with a small circumcircle, adds the points in the
+	 *  order of their distance from its circumcenter by connecting each one
+	 *  to the hull edges visible from it, and then makes the triangulation
+	 *  Delaunay with a single Lawson flip pass.
+	 *  Returns an edge of the triangulation, or a NULL pointer
+	 *  if all the points are collinear. */
+	Edge::Ptr sweepHullDelaunay();
+
+
+	/** Orders the points in a Biased Randomized Insertion Order :
+	 *  rounds of geometrically increasing size, each sorted along a Hilbert curve. */
+	void brioOrder(std::vector<int> &order);
+
+
+	/** Randomized incremental delaunay triangulation.
+	 *  Inserts the points in BRIO order, locating each one by
+	 *  walking from the previously inserted point.
+	 *  Returns an edge of the triangulation, or a NULL pointer
+	 *  if all the points are collinear (no triangle can be seeded). */
+	Edge::Ptr incrementalDelaunay();
 
 
 
@@ -119,25 +279,315 @@ public:
 	 *  PTS   : vector of points. it is assumed that PTS.size() > 1
 	 *  start : the start index of PTS
 	 *  end   : the end index   of PTS
-	 *  axis  : the axis along which the point-set needs to be cut. */
-	std::pair<Edge::Ptr, Edge::Ptr>
+	 *  axis  : the axis along which the point-set needs to be cut.
+	 *
+	 *  Returns all the four extreme hull edges of the triangulation. */
+	HullHandles
 	divideConquerAlternatingCuts(int start, int end, int axis=1);
 
 
 
+	/** Seam-first (DeWall) triangulation [Cignoni, Montani & Scopigno, 1998],
+	 *  run on parallel threads : PARALLEL_CUTS.
+	 *
+	 *  ********** THIS FUNCTION DOES NOT ASSUME THAT THE POINTS ARE SORTED**********
+	 *
+	 *  The sorted sites are cut at the middle rank, and the seam, the
+	 *  Delaunay triangles across the cut, is built first : from an edge
+	 *  on its side, the triangle is closed by the site whose circle is
+	 *  empty, found in a grid of buckets, and the new edges across the cut
+	 *  are worked on in turn. The two halves then share no triangle to
+	 *  build; each is cut and seamed again, from the edges the seam left
+	 *  on its side, on its own thread for the top log2(num_threads)
+	 *  levels, and the last ranges are filled in from their edges alone.
+	 *  Nothing is merged. Cocircular sites are told apart the same way in
+	 *  every range, and duplicates are left out.
+	 *
+	 *  Returns a ccw hull edge (outer face on its right) out of the
+	 *  lexico-smallest site, or a null edge if the sites are collinear. */
+	Edge::Ptr dewallDelaunay();
+
+	/** Triangulates the sites with the vertical cuts, for the engines which
+	 *  return a null edge when they are all collinear (INCREMENTAL,
+	 *  SWEEP_HULL, PARALLEL_CUTS). Returns a ccw hull edge, also kept as
+	 *  hull_edge. */
+	Edge::Ptr collinearFallback();
+
+	/** Multi-process version of the VERTICAL CUTS divide-and-conquer.
+	 *
+	 *  ********** THIS FUNCTION DOES NOT ASSUME THAT THE POINTS ARE SORTED**********
+	 *
+	 *  The sorted points, less their duplicates (left at the end of PTS,
+	 *  see dropDuplicates), are cut into PROCS strips of equal size. A
+	 *  forked worker process triangulates each one and writes it, with its
+	 *  hull handles, to a file next to the output (see packTriangulation).
+	 *  The seams are then merged pairwise, a level at a time, each merge in
+	 *  a worker of its own; the last one runs in this process, which keeps
+	 *  only the points till then. */
+	std::pair<Edge::Ptr, Edge::Ptr> divideConquerProcesses(int procs);
+
+	/** Dwyer's [1987] cell-bucketing variant of the divide-and-conquer.
+	 *
+	 *  ********** THIS FUNCTION DOES NOT ASSUME THAT THE POINTS ARE SORTED**********
+	 *
+	 *  The bounding box is cut into sqrt(n/log n) vertical strips, each
+	 *  cut into as many cells. Cells are triangulated with vertical cuts,
+	 *  merged bottom-to-top within each strip, and the strips are then
+	 *  merged left-to-right. Linear expected time for uniform points.
+	 *  Duplicates are left out, at the end of PTS.
+	 *
+	 *  Returns all the four extreme hull edges of the triangulation. */
+	HullHandles dwyerDelaunay();
+
+	/** Triangulates [start, end] (inclusive) with vertical cuts
+	 *  and returns all the four extreme hull edges. */
+	HullHandles triangulateRange(int start, int end);
+
+	/** Moves the duplicates out of the lexico-sorted range [start, end]
+	 *  (inclusive) of PTS to its end, keeping the first site in file order
+	 *  of each point. Returns the number of sites which stay. */
+	int dropDuplicates(int start, int end);
+
+	/** Merges the triangulations in HS, which are separated along AXIS
+	 *  and ordered along it, pairwise in a balanced tree. */
+	HullHandles mergeAll(std::vector<HullHandles> &hs, int axis);
+
+	/** Scans the points for the bounding box and exact duplicates, and
+	 *  buckets a fixed size sample of them to measure clustering. O(n). */
+	InputProfile probeInput();
+
+	/** Picks the algorithm (and sets num_threads) suited to the profile P. */
+	CutsType chooseAlgorithm(const InputProfile &p);
+
+	/** Collects all the quad-edges reachable from randEdge. */
+	void collectQuadEdges(std::vector<QuadEdge::Ptr> &qedges);
+
+	/** Frees all the quad-edges of the subdivision. */
+	void clearSubdivision();
+
+	/** Fills site_edges with an edge out of every vertex. O(n). */
+	void indexSites();
+
+	/** Returns the edge of site_edges out of V,
+	 *  or a NULL pointer if it has been deleted or flipped away from V. */
+	Edge::Ptr siteEdge(int v);
+
+	/** Points site_edges of E's origin and of all its neighbours at E's ring. */
+	void refreshRing(Edge::Ptr e);
+
+	/** Jump-and-walk [Mucke et al., 1996] start : returns an edge out of
+	 *  the vertex nearest to P among ~n^(1/3) random vertices. */
+	Edge::Ptr nearbyEdge(const Eigen::Vector2d &p);
+
+	/** Re-triangulates the face left of the new constrained edge BASE,
+	 *  a pseudo-polygon, as a constrained Delaunay triangulation. */
+	void triangulateCavity(Edge::Ptr base);
+
+	/** Is the vertex P strictly inside the diametral circle of the edge S? */
+	bool encroaches(int p, Edge::Ptr s);
+
+	/** Is the constrained edge S encroached by the apex of a triangle beside it? */
+	bool isEncroached(Edge::Ptr s);
+
+	/** Straight walk from the triangle left of T towards C. Returns an edge of
+	 *  the triangle containing C, or sets CROSSED to the first constrained
+	 *  edge in the way (and returns NULL). */
+	Edge::Ptr walkToward(Edge::Ptr t, const Eigen::Vector2d &c, Edge::Ptr &crossed);
+
+	/** Splits the constrained edge S, at its midpoint or on a concentric
+	 *  shell about its input end. Returns the new site. */
+	int splitSegment(Edge::Ptr s, RefineState &q);
+
+	/** True if the sites P and R split two segments at a small input angle. */
+	bool acrossInputAngle(int p, int r, const RefineState &q);
+
+	/** Queues the triangle left of E if it is bad : see refine. */
+	void queueTriangle(Edge::Ptr e, RefineState &q);
+
+	/** Queues the bad triangles and the encroached segments around the site V. */
+	void queueAround(int v, RefineState &q);
+
+	/** Devillers' [1999] priority of the ear (A, B, C) of the star of
+	 *  the removed vertex X : the power of X wrt the circle through A, B, C.
+	 *  The ear with the largest power (X least deep inside its circle)
+	 *  is a Delaunay triangle. */
+	double earPower(int a, int b, int c, int x);
+
+	/** Thread entry for locateAll : locates the queries ORDER[start, end)
+	 *  one after the other, each walk starting at the previous answer. */
+	void locateRange(const std::vector<Vector2dPtr> *ptrs, const std::vector<int> *order,
+			int start, int end, std::vector<Edge::Ptr> *result);
+
+
+
 public:
 	typedef boost::shared_ptr<DelaunaySubdivision> Ptr;
 
 	DelaunaySubdivision(std::string fname, std::string outname="xdefaultx");
 
+	/** Triangulates the sites IDS of PTRS : the points are shared, not copied. */
+	DelaunaySubdivision(const std::vector<int> &ids, const std::vector<Vector2dPtr> &ptrs,
+			std::string outname="xdefaultx");
+
 	//pointer to a quad-edge of the subdivision
 	QuadEdge::Ptr randEdge;
 	int num_qedges;
 
+	// number of threads used by PARALLEL_CUTS, or of worker processes
+	// used by PROCESS_CUTS. Defaults to the number of cores.
+	int num_threads;
+
+	// a ccw hull edge (outer face on its right), kept from the handles
+	// computeDelaunay gets back. See convexHull.
+	Edge::Ptr hull_edge;
+
+	// an edge out of every vertex : built lazily by indexSites, and kept
+	// up to date by swap and deleteEdge once built; see siteEdge.
+	std::vector<Edge::Ptr> site_edges;
+
+	// random source for the jump-and-walk samples.
+	boost::mt19937 rng;
+
 	/** Main interface function.
-	 *  T specifies which algorithm to use.*/
+	 *  T specifies which algorithm to use.
+	 *  AUTO_CUTS probes the input and picks one; the choice is printed.*/
 	void computeDelaunay(CutsType t=ALTERNATE_CUTS, bool time=false);
 
+	// the weight of each site, for the regular triangulation : set by
+	// computeRegular, empty for a Delaunay triangulation.
+	std::vector<double> weights;
+
+	// the sites which are not vertices of the regular triangulation, in
+	// the order they were hidden : those in a triangle whose orthogonal
+	// circle they do not reach, and the lighter of coincident sites.
+	std::vector<int> hidden;
+
+	/** Regular (weighted Delaunay) triangulation of the sites, weighted by
+	 *  the vertex attribute CHANNEL : the projection of the lower convex hull
+	 *  of the points lifted to x^2 + y^2 - w. Randomized incremental in BRIO
+	 *  order (Edelsbrunner and Shah [1996]) : a site is hidden on insertion
+	 *  if its power test against its triangle is not positive; else it is
+	 *  connected and the link edges are flipped regular by 2-2 flips, and by
+	 *  3-1 flips which hide vertices that stop being extreme. Coincident sites
+	 *  keep the heaviest. With zero weights, the Delaunay triangulation.
+	 *  insertSite, removeSite and insertSegment are not supported on it. */
+	void computeRegular(int channel=0, bool time=false);
+
+	/** Inserts the new site (X, Y) into the triangulation computed by
+	 *  computeDelaunay, and keeps it Delaunay. The site gets the index
+	 *  point_ptrs.size(). Expected O(n^(1/3)) time for the search, plus
+	 *  O(1) flips. Returns an edge out of the new site, or, if (X, Y)
+	 *  is already a vertex, an edge out of that vertex. */
+	Edge::Ptr insertSite(double x, double y);
+
+	/** As insertSite, for the point P with the index ID, which must not be
+	 *  in use in this subdivision. The search starts at HINT if it is given,
+	 *  which lets DelaunayHierarchy insert the same point at several levels.*/
+	Edge::Ptr insertSiteIndex(int id, Vector2dPtr p, Edge::Ptr hint=Edge::Ptr());
+
+	/** Removes the site ID from the triangulation and re-triangulates its
+	 *  star by clipping ears in Devillers' order. O(d log d) time for a
+	 *  vertex of degree d. The indices of the other sites do not change;
+	 *  point_ptrs[ID] is reset, and ID is dropped from points lazily, by the
+	 *  next computeDelaunay. Returns false if ID is not a vertex.*/
+	bool removeSite(int id);
+
+	/** Moves the site v to row v of POSITIONS (which has a row per entry
+	 *  of point_ptrs), in place, and repairs the triangulation instead of
+	 *  computing it again. The sites which moved are moved one at a time :
+	 *  a site whose triangles stay ccw keeps its edges, which are made
+	 *  Delaunay again by flips, and any other one is removed and inserted
+	 *  again. The work is O(1) for each site which moves a little, as
+	 *  site_edges is kept from one call to the next. If more sites than
+	 *  MAX_INVERTED of the triangles turn one of their triangles over (the
+	 *  sites on the hull do not count), a site was left out as a duplicate
+	 *  or lands on another one, or a site with a segment can not keep its
+	 *  edges, the triangulation is computed again (incremental, then the
+	 *  segments). Returns true if it was repaired in place. */
+	bool updateCoordinates(const RowMatrixXd &positions, double max_inverted=0.01, bool time=false);
+
+	/** Batch point location on the finished triangulation.
+	 *  IDS index into PTRS, like points into point_ptrs. RESULT[i] is set to
+	 *  the edge locate() gives for the point IDS[i] : the point is in the
+	 *  triangle to its left, or outside the hull if that is the outer face.
+	 *  The queries are sorted along a Hilbert curve, so consecutive walks
+	 *  are short, and split in contiguous runs over num_threads threads.
+	 *  With TIME, the throughput is printed. */
+	void locateAll(const std::vector<int> &ids, const std::vector<Vector2dPtr> &ptrs,
+			std::vector<Edge::Ptr> &result, bool time=false);
+
+	// the vertex attributes of the input : row v holds those of the site v,
+	// one column per attribute, stored column major so that each channel is
+	// contiguous. No rows for Steiner points.
+	ColMatrixXd attributes;
+
+	// the segments of the .poly input : pairs of vertex indices.
+	std::vector<std::pair<int, int> > segments;
+
+	/** Makes the segment A-B an edge of the triangulation, and keeps the
+	 *  triangulation constrained Delaunay : the edges it crosses are deleted,
+	 *  and the two cavities are re-triangulated. The constrained edges are
+	 *  not flipped by later insertions, and a site inserted on one splits it;
+	 *  removeSite drops the segments at the removed site. Returns false if
+	 *  the segment crosses another one; its pieces up to there are kept. */
+	bool insertSegment(int a, int b);
+
+	/** Inserts all of segments into the triangulation computed by computeDelaunay.*/
+	void insertSegments(bool time=false);
+
+	/** Ruppert's [1995] Delaunay refinement of the (constrained) triangulation,
+	 *  by incremental insertion of Steiner points, till no angle is below
+	 *  MIN_ANGLE degrees and no triangle has an area above MAX_AREA (if it is
+	 *  positive). The hull edges become segments. Angles up to ~20.7 degrees
+	 *  are guaranteed to terminate when the segments meet at 60 degrees or
+	 *  more. Smaller input angles are kept, as in Shewchuk [2002] : segments
+	 *  are split on concentric shells, and the triangles across such angles
+	 *  are left skinny. MAX_STEINER (if not negative) caps the number of new sites.
+	 *  With TIME, the time of each stage is printed. Returns the number of
+	 *  Steiner points. */
+	int refine(double min_angle=20.0, double max_area=-1.0, int max_steiner=-1, bool time=false);
+
+	/** The vertices of the convex hull of the triangulation, in ccw order,
+	 *  without the vertices in the middle of hull edges. Walks the outer
+	 *  face from hull_edge in O(h); hull_edge is found again, by a walk to a
+	 *  point outside the hull, if insertSite or removeSite has moved the hull.
+	 *  Collinear sites give their two end points. */
+	void convexHull(std::vector<int> &hull);
+
+	/** As convexHull, without triangulating : Andrew's monotone chain
+	 *  on the lexicographically sorted points. O(n log n). */
+	void monotoneChainHull(std::vector<int> &hull);
+
+	/** Appends the triangles to TRIS, 3 ccw vertices each, starting at the
+	 *  smallest one : each is found once, from the edge out of it. */
+	void triangles(std::vector<int> &tris);
+
+	/** Freezes the triangles as TRIS (3 ccw vertices each, as triangles)
+	 *  and NBRS : the triangle across the edge (v_k, v_k+1) of each, or -1
+	 *  on the hull. O(n). */
+	void triangleMesh(std::vector<int> &tris, std::vector<int> &nbrs);
+
+	// the Voronoi vertices, filled by computeVoronoi : row f is the
+	// circumcenter of the triangle (dual vertex) f.
+	Eigen::MatrixXd voronoi_vertices;
+
+	/** Numbers the triangles 0..F-1, and makes the number of the left face
+	 *  of each primal edge e the origin of e->RotInv() (-1 for the outer
+	 *  face), so that e->Rot() is the dual (Voronoi) edge of e, from its
+	 *  right face to its left face. The circumcenters are computed once
+	 *  per triangle into voronoi_vertices. Returns the number of triangles.*/
+	int computeVoronoi();
+
+	/** As computeVoronoi, and keeps the quad-edges it collects in QEDGES. */
+	int computeVoronoi(std::vector<QuadEdge::Ptr> &qedges);
+
+	/** Voronoi cells of the sites, clipped to the box [LO, HI], as flat arrays :
+	 *  cell i belongs to SITES[i] and has the ccw vertices
+	 *  (COORDS[2j], COORDS[2j+1]) for j in [OFFSETS[i], OFFSETS[i+1]).
+	 *  Needs computeVoronoi. */
+	void voronoiCells(const Eigen::Vector2d &lo, const Eigen::Vector2d &hi,
+			std::vector<int> &sites, std::vector<int> &offsets, std::vector<double> &coords);
+
 	/** Writes this subdivision to file.*/
 	void writeToFile();
 };
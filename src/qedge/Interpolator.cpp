@@ -0,0 +1,195 @@
+/** Linear and natural neighbour interpolation of the vertex attributes.
+ *  See Interpolator.h */
+
+#include "Interpolator.h"
+#include "utils/misc.h"
+#include "utils/sorting.h"
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <limits>
+#include <cmath>
+#include <iostream>
+
+using namespace Eigen;
+using namespace std;
+
+
+/** Checks that SUB is triangulated. */
+Interpolator::Interpolator(DelaunaySubdivision *_sub, bool _sibson)
+	: sub(_sub), sibson(_sibson) {
+	if (!sub->randEdge) {
+		cout << "Interpolation : compute the triangulation first. Exiting.\n";
+		exit(-1);
+	}
+}
+
+
+/** True if the triangle T (3 vertices) has the vertices U, V and W. */
+static inline bool hasVertices(const int *t, int u, int v, int w) {
+	const bool hu = t[0] == u || t[1] == u || t[2] == u;
+	const bool hv = t[0] == v || t[1] == v || t[2] == v;
+	const bool hw = t[0] == w || t[1] == w || t[2] == w;
+	return hu && hv && hw;
+}
+
+
+/** Barycentric or natural neighbour (Sibson) weights at X, in the
+ *  triangle left of E.
+ *
+ *  The natural neighbours of X are the vertices of its Bowyer-Watson
+ *  cavity : the triangles whose circumcircle holds X, grown from the one
+ *  of E over the edges. Inserting X would make the boundary edges v_i v_i+1
+ *  (ccw) triangles with X, whose circumcenters p_i are the vertices of the
+ *  Voronoi cell of X. The area it takes from the cell of v_i is the polygon
+ *  p_i, the circumcenters of the cavity triangles at v_i (ccw), p_i-1. */
+bool Interpolator::weights(const Vector2d &x, Edge::Ptr e, vector<int> &sites,
+		vector<double> &weights) {
+	const vector<Vector2dPtr> &point_ptrs = sub->point_ptrs;
+	sites.clear(); weights.clear();
+	const int a = e->org(), b = e->dest(), c = e->Onext()->dest();
+	if (!sub->CCW(a, b, c)) return false; // the outer face : outside the hull
+	const Vector2d &pa = *point_ptrs[a], &pb = *point_ptrs[b], &pc = *point_ptrs[c];
+
+	if (sibson) {
+		if (x == pa || x == pb || x == pc) {
+			sites.push_back((x == pa)? a : ((x == pb)? b : c));
+			weights.push_back(1.0);
+			return true;
+		}
+		vector<Edge::Ptr> cavity(1, e), bound;
+		vector<int> verts(3);
+		verts[0] = a; verts[1] = b; verts[2] = c;
+		bool on_hull = false;
+		for (int k = 0; k < cavity.size() && !on_hull; k += 1) {
+			Edge::Ptr d = cavity[k];
+			for (int j = 0; j < 3; j += 1, d = d->Lnext()) {
+				Edge::Ptr s = d->Sym();
+				const int u = s->org(), v = s->dest(), w = s->Onext()->dest();
+				bool inside = false;
+				if (sub->CCW(u, v, w)) {
+					for (int t = 0; t < verts.size() && !inside; t += 3)
+						inside = hasVertices(&verts[t], u, v, w);
+					if (!inside && incircle(*point_ptrs[u], *point_ptrs[v], *point_ptrs[w], x) > 0) {
+						inside = true;
+						cavity.push_back(s);
+						verts.push_back(u); verts.push_back(v); verts.push_back(w);
+					}
+				} else if (orient2d(*point_ptrs[v], *point_ptrs[u], x) == 0) {
+					on_hull = true; // Sibson is linear on the hull edges
+					break;
+				}
+				if (!inside) bound.push_back(d);
+			}
+		}
+
+		if (!on_hull) {
+			// chain the boundary edges ccw.
+			const int m = bound.size();
+			for (int i = 1; i < m; i += 1) {
+				for (int j = i; j < m; j += 1) {
+					if (bound[j]->org() == bound[i-1]->dest()) {
+						std::swap(bound[i], bound[j]);
+						break;
+					}
+				}
+			}
+			vector<Vector2d> p(m);
+			for (int i = 0; i < m; i += 1)
+				p[i] = circumcenter(x, *point_ptrs[bound[i]->org()], *point_ptrs[bound[i]->dest()]);
+
+			double total = 0.0;
+			vector<Vector2d> poly;
+			for (int i = 0; i < m; i += 1) {
+				const int v = bound[i]->org(), prev = bound[(i+m-1) % m]->org();
+				poly.assign(1, p[i]);
+				Edge::Ptr f = bound[i];
+				do {
+					poly.push_back(circumcenter(*point_ptrs[v], *point_ptrs[f->dest()],
+							*point_ptrs[f->Onext()->dest()]));
+					f = f->Onext();
+				} while (f->dest() != prev);
+				poly.push_back(p[(i+m-1) % m]);
+
+				double area = 0.0;
+				for (int j = 0; j < poly.size(); j += 1) {
+					const Vector2d &q0 = poly[j], &q1 = poly[(j+1) % poly.size()];
+					area += q0.x()*q1.y() - q0.y()*q1.x();
+				}
+				sites.push_back(v);
+				weights.push_back(std::abs(area));
+				total += std::abs(area);
+			}
+			for (int i = 0; i < m; i += 1) weights[i] /= total;
+			return true;
+		}
+		sites.clear(); weights.clear(); // X on the hull : linear
+	}
+
+	const double area = orient2d(pa, pb, pc);
+	sites.push_back(a); weights.push_back(orient2d(x, pb, pc) / area);
+	sites.push_back(b); weights.push_back(orient2d(pa, x, pc) / area);
+	sites.push_back(c); weights.push_back(orient2d(pa, pb, x) / area);
+	return true;
+}
+
+
+/** Thread entry for interpolate : the queries ORDER[start, end). */
+void Interpolator::interpolateRange(const std::vector<Vector2dPtr> *ptrs,
+		const std::vector<int> *order, int start, int end,
+		const RowMatrixXd *rows, RowMatrixXd *values) {
+	vector<int> sites;
+	vector<double> weights;
+	Edge::Ptr e = sub->randEdge->edges[0];
+	for (int i = start; i < end; i += 1) {
+		const int q = (*order)[i];
+		e = sub->locate(*(*ptrs)[q], e);
+		if (!this->weights(*(*ptrs)[q], e, sites, weights)) {
+			values->row(q).setConstant(std::numeric_limits<double>::quiet_NaN());
+			continue;
+		}
+		// all the channels at once : both rows are contiguous.
+		values->row(q).setZero();
+		for (int j = 0; j < sites.size(); j += 1)
+			values->row(q).noalias() += weights[j] * rows->row(sites[j]);
+	}
+}
+
+
+/** Batch interpolation of the vertex attributes.*/
+void Interpolator::interpolate(const std::vector<int> &ids, const std::vector<Vector2dPtr> &ptrs,
+		RowMatrixXd &values, bool time) {
+	const ColMatrixXd &attributes = sub->attributes;
+	const int Q = ids.size(), K = attributes.cols();
+	values.resize(Q, K);
+	if (K == 0 || attributes.rows() < sub->point_ptrs.size()) {
+		cout << ">>> " << ((K == 0)? "The input has no vertex attributes" :
+				"The sites added after the input have no attributes") << " to interpolate. Skipping.\n";
+		return;
+	}
+	double tim = wallTime();
+
+	// sorted as in locateAll.
+	vector<Vector2dPtr> qptrs(Q);
+	vector<int> order(Q);
+	for (int i = 0; i < Q; i += 1) {
+		qptrs[i] = ptrs[ids[i]];
+		order[i] = i;
+	}
+	hilbertSort(order, &qptrs, 0, Q-1);
+	const RowMatrixXd rows = attributes;
+
+	initPredicates();
+	const int T = std::max(1, std::min(sub->num_threads, Q/4096));
+	boost::thread_group workers;
+	for (int t = 1; t < T; t += 1)
+		workers.create_thread(boost::bind(&Interpolator::interpolateRange, this,
+				&qptrs, &order, (int) ((long) Q*t/T), (int) ((long) Q*(t+1)/T), &rows, &values));
+	interpolateRange(&qptrs, &order, 0, Q/T, &rows, &values);
+	workers.join_all();
+
+	if (time) {
+		tim = wallTime() - tim;
+		cout <<">>> interpolated "<<K<<" attributes at "<<Q<<" points in "<<tim<<" seconds ("
+			 <<Q/tim<<" queries/s, "<<T<<" threads, "<<(sibson? "natural neighbours" : "linear")<<").\n";
+	}
+}
@@ -0,0 +1,54 @@
+/** Interpolation of the vertex attributes of a Delaunay triangulation.
+ *
+ *  Linear interpolation over the triangle of each point, or Sibson's
+ *  [1981] natural neighbour interpolation, whose weights are stolen
+ *  Voronoi areas, found from the Bowyer-Watson cavity of the point
+ *  (Watson [1992]). Points outside the hull get NaN.
+ *
+ *  A batch is sorted along a Hilbert curve, as in locateAll, and split
+ *  over num_threads threads; each point is interpolated right after its
+ *  walk, all the channels at once : the attributes are copied row major
+ *  for the batch, so that the channels of a site are contiguous and each
+ *  weighted row is added with Eigen's SIMD packets. */
+
+#ifndef __INTERPOLATOR_H__
+#define __INTERPOLATOR_H__
+
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include "DelaunaySubdivision.h"
+
+
+class Interpolator {
+public:
+	typedef boost::shared_ptr<Interpolator> Ptr;
+
+	/** Interpolates over SUB, which must be triangulated already : with
+	 *  SIBSON by natural neighbours, else linearly. */
+	Interpolator(DelaunaySubdivision *sub, bool sibson=false);
+
+	/** The sites and weights which interpolate at X, in the triangle left
+	 *  of E (as located) : its three vertices, with barycentric weights, or
+	 *  with sibson the natural neighbours of X, weighted by the area each
+	 *  would lose to X's Voronoi cell. False if X is outside the hull. */
+	bool weights(const Eigen::Vector2d &x, Edge::Ptr e, std::vector<int> &sites,
+			std::vector<double> &weights);
+
+	/** Batch interpolation of all the attributes of the sites at the points
+	 *  IDS (into PTRS, as locateAll) : row i of VALUES gets them at the
+	 *  point IDS[i]. With TIME, the throughput is printed. */
+	void interpolate(const std::vector<int> &ids, const std::vector<Vector2dPtr> &ptrs,
+			RowMatrixXd &values, bool time=false);
+
+private:
+	DelaunaySubdivision *sub;
+	bool sibson;
+
+	/** Thread entry for interpolate : locates the queries ORDER[start, end)
+	 *  as locateRange, and fills their rows of VALUES from the row major copy
+	 *  ROWS of the attributes as soon as each is found. */
+	void interpolateRange(const std::vector<Vector2dPtr> *ptrs, const std::vector<int> *order,
+			int start, int end, const RowMatrixXd *rows, RowMatrixXd *values);
+};
+
+#endif
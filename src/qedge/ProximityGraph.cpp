@@ -0,0 +1,143 @@
+/** Gabriel and relative neighbourhood graphs from the Delaunay edges.
+ *  See ProximityGraph.h */
+
+#include "ProximityGraph.h"
+#include "utils/misc.h"
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <iostream>
+
+using namespace Eigen;
+using namespace std;
+
+
+/** Fills the CSR adjacency GRAPH of the N sites with the edges i of ENDS
+ *  for which KEEP[i] is set (or all of them if KEEP is NULL). */
+static void buildCSR(int n, const vector<int> &ends, const vector<char> *keep, CSRGraph &graph) {
+	const int E = ends.size() / 2;
+	graph.offsets.assign(n+1, 0);
+	for (int i = 0; i < E; i += 1) {
+		if (keep && !(*keep)[i]) continue;
+		graph.offsets[ends[2*i]+1]   += 1;
+		graph.offsets[ends[2*i+1]+1] += 1;
+	}
+	for (int v = 0; v < n; v += 1)
+		graph.offsets[v+1] += graph.offsets[v];
+	graph.targets.resize(graph.offsets[n]);
+	vector<int> next(graph.offsets.begin(), graph.offsets.end() - 1);
+	for (int i = 0; i < E; i += 1) {
+		if (keep && !(*keep)[i]) continue;
+		const int a = ends[2*i], b = ends[2*i+1];
+		graph.targets[next[a]++] = b;
+		graph.targets[next[b]++] = a;
+	}
+}
+
+
+/** Tests the edges [start, end) of frozen : only the point coordinates
+ *  and the flat arrays are read, so the threads share nothing else. */
+void ProximityGraph::testRange(int start, int end, std::vector<char> *keep) {
+	const vector<Vector2dPtr> &point_ptrs = sub->point_ptrs;
+	const FrozenEdges *E = &frozen;
+	vector<int> mark(rng? point_ptrs.size() : 0, -1), queue;
+	for (int i = start; i < end; i += 1) {
+		const int a = E->ends[2*i], b = E->ends[2*i+1];
+		const Vector2d &pa = *point_ptrs[a], &pb = *point_ptrs[b];
+		bool in = true;
+		// the closed diametral disk : then the Gabriel graph is in any
+		// Delaunay triangulation, even of cocircular sites.
+		for (int k = 0; k < 2 && in; k += 1) {
+			const int c = E->apexes[2*i+k];
+			if (c >= 0 && indiametral(pa, pb, *point_ptrs[c]) >= 0.0) in = false;
+		}
+		if (!in || !rng) {
+			(*keep)[i] = in;
+			continue;
+		}
+
+		// the lune of ab : the sites closer to both a and b than they are to
+		// each other. An apex in it settles the edge.
+		for (int k = 0; k < 2 && in; k += 1) {
+			const int c = E->apexes[2*i+k];
+			if (c >= 0 && closer(pa, pb, *point_ptrs[c]) > 0.0 && closer(pb, pa, *point_ptrs[c]) > 0.0)
+				in = false;
+		}
+
+		// else search the open disk about one end through the other : it holds
+		// the lune, and the sites strictly inside a disk are connected to its
+		// centre through sites strictly inside it in the Delaunay graph. So a
+		// breadth first search from the centre finds them all, and the other
+		// end, on the boundary, is never scanned : the end of the larger degree
+		// (a hub) is put there.
+		const CSRGraph &D = E->delaunay;
+		int o = a, m = b; // the other end and the centre
+		if (D.offsets[a+1] - D.offsets[a] < D.offsets[b+1] - D.offsets[b]) std::swap(o, m);
+		const Vector2d &po = *point_ptrs[o], &pm = *point_ptrs[m];
+		queue.assign(1, m);
+		mark[m] = i;
+		for (int h = 0; h < queue.size() && in; h += 1) {
+			const int v = queue[h];
+			for (int j = D.offsets[v]; j < D.offsets[v+1] && in; j += 1) {
+				const int c = D.targets[j];
+				if (mark[c] == i) continue;
+				mark[c] = i;
+				const Vector2d &pc = *point_ptrs[c];
+				if (closer(pm, po, pc) <= 0.0) continue; // not strictly inside
+				if (closer(po, pm, pc) > 0.0) in = false;
+				queue.push_back(c);
+			}
+		}
+		(*keep)[i] = in;
+	}
+}
+
+
+/** Freezes the edges with their apexes, then filters them in parallel. */
+ProximityGraph::ProximityGraph(DelaunaySubdivision *_sub, bool _rng, bool time)
+	: sub(_sub), rng(_rng) {
+	if (!sub->randEdge) {
+		cout << "Proximity graph : compute the triangulation first. Exiting.\n";
+		exit(-1);
+	}
+	const int n = sub->point_ptrs.size();
+	double tim = wallTime();
+	FrozenEdges &F = frozen;
+	{
+		vector<QuadEdge::Ptr> qedges;
+		sub->collectQuadEdges(qedges);
+		F.ends.resize(2*qedges.size());
+		F.apexes.resize(2*qedges.size());
+		for (int i = 0; i < qedges.size(); i += 1) {
+			Edge::Ptr e = qedges[i]->edges[0];
+			const int a = e->org(), b = e->dest();
+			// the next edges around a lead to the apexes, if they are triangles.
+			const int l = e->Onext()->dest(), r = e->Oprev()->dest();
+			F.ends[2*i] = a; F.ends[2*i+1] = b;
+			F.apexes[2*i]   = sub->CCW(a, b, l)? l : -1;
+			F.apexes[2*i+1] = sub->CCW(b, a, r)? r : -1;
+		}
+	}
+	const int E = F.ends.size() / 2;
+	if (rng) buildCSR(n, F.ends, NULL, F.delaunay);
+	const double tim_freeze = wallTime() - tim;
+
+	tim = wallTime();
+	initPredicates();
+	vector<char> keep(E);
+	const int T = std::max(1, std::min(sub->num_threads, E/4096));
+	boost::thread_group workers;
+	for (int t = 1; t < T; t += 1)
+		workers.create_thread(boost::bind(&ProximityGraph::testRange, this,
+				(int) ((long) E*t/T), (int) ((long) E*(t+1)/T), &keep));
+	testRange(0, E/T, &keep);
+	workers.join_all();
+	const double tim_filter = wallTime() - tim;
+
+	tim = wallTime();
+	buildCSR(n, F.ends, &keep, graph);
+	if (time) {
+		cout <<">>> "<<(rng? "relative neighbourhood" : "Gabriel")<<" graph : "<<tim_freeze
+			 <<" seconds to freeze "<<E<<" edges, "<<tim_filter<<" seconds to test them on "
+			 <<T<<" threads, "<<wallTime()-tim<<" seconds for the CSR of "<<graph.numEdges()<<" edges.\n";
+	}
+}
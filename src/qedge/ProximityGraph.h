@@ -0,0 +1,59 @@
+/** Gabriel graph and relative neighbourhood graph of the sites of a
+ *  Delaunay triangulation, which holds both among its edges.
+ *
+ *  The Gabriel graph is the Delaunay edges whose closed diametral disk
+ *  holds no other site, which is decided by the two apexes of their
+ *  triangles. The relative neighbourhood graph is the Gabriel edges ab
+ *  whose lune is empty. An apex in the lune settles an edge. Else the lune
+ *  is searched over the Delaunay edges from the end of smaller degree,
+ *  through the sites strictly inside the disk about it through the other
+ *  end : they are connected, and the other end, a hub maybe, is never
+ *  scanned. That is O(1) sites per edge for well spread points, but an
+ *  edge with an empty lune costs all the sites of that disk : O(n) per
+ *  edge, and O(n^2) in all, for n sites cocircular about a centre (a wheel).
+ *
+ *  The subdivision is frozen into flat arrays first, and the edges are
+ *  then tested in parallel on num_threads threads. */
+
+#ifndef __PROXIMITY_GRAPH_H__
+#define __PROXIMITY_GRAPH_H__
+
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include "DelaunaySubdivision.h"
+#include "DelaunayGraph.h"
+
+
+/** The subdivision frozen into flat arrays : for each edge i, its end
+ *  points ENDS[2i], ENDS[2i+1] and the apexes of its left and right
+ *  triangles APEXES[2i], APEXES[2i+1] (-1 on the outer face). */
+struct FrozenEdges {
+	std::vector<int> ends;
+	std::vector<int> apexes;
+	CSRGraph delaunay; // only for the relative neighbourhood graph
+};
+
+
+class ProximityGraph {
+public:
+	typedef boost::shared_ptr<ProximityGraph> Ptr;
+
+	/** Computes the Gabriel graph of the sites of SUB, or with RNG their
+	 *  relative neighbourhood graph. SUB must be triangulated already.
+	 *  With TIME, the time of each stage is printed. */
+	ProximityGraph(DelaunaySubdivision *sub, bool rng, bool time=false);
+
+	// the graph : each edge in both directions.
+	CSRGraph graph;
+
+private:
+	DelaunaySubdivision *sub;
+	bool rng;
+	FrozenEdges frozen;
+
+	/** Thread entry : sets KEEP[i] for the edges i in [start, end) of
+	 *  frozen which are in the graph. */
+	void testRange(int start, int end, std::vector<char> *keep);
+};
+
+#endif
@@ -31,6 +31,10 @@ public:
 
 	int visit_num;
 
+	// is this edge an input segment of a constrained triangulation?
+	// DelaunaySubdivision::swap does not flip such edges.
+	bool constrained;
+
 	typedef	 boost::shared_ptr<QuadEdge> Ptr;
 	std::vector<boost::shared_ptr<Edge> > edges;
 
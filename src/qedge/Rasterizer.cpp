@@ -0,0 +1,166 @@
+/** Tile-parallel rasterization of a TIN.
+ *  See Rasterizer.h */
+
+#include "Rasterizer.h"
+#include "utils/misc.h"
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <limits>
+#include <cmath>
+#include <iostream>
+
+using namespace Eigen;
+using namespace std;
+
+
+/** Checks that SUB is triangulated. */
+Rasterizer::Rasterizer(DelaunaySubdivision *_sub, int _channel)
+	: sub(_sub), channel(_channel) {
+	if (!sub->randEdge) {
+		cout << "Rasterization : compute the triangulation first. Exiting.\n";
+		exit(-1);
+	}
+}
+
+
+/** Widens [LO, HI] to where the scan line v = J crosses the edge P-Q (in
+ *  cell coordinates). The end points are ordered first, so that the two
+ *  triangles of an edge work out the same crossing. */
+static inline void crossEdge(double pu, double pv, double qu, double qv, int j,
+		double &lo, double &hi) {
+	if (qv < pv || (qv == pv && qu < pu)) {
+		std::swap(pu, qu); std::swap(pv, qv);
+	}
+	if (j < pv || j > qv) return;
+	if (pv == qv) { // along the scan line
+		lo = std::min(lo, pu); hi = std::max(hi, qu);
+		return;
+	}
+	const double u = pu + (j - pv) * (qu - pu) / (qv - pv);
+	lo = std::min(lo, u); hi = std::max(hi, u);
+}
+
+
+/** Thread entry for rasterize : the tiles FIRST, FIRST+STRIDE, ... */
+void Rasterizer::rasterTiles(const RasterTiles *T, int first, int stride, RasterGrid *grid) {
+	const ColMatrixXd &attributes = sub->attributes;
+	const int W = grid->width, H = grid->height;
+	for (int t = first; t < T->cols*T->rows; t += stride) {
+		const int ci0 = (t % T->cols) * T->size, cj0 = (t / T->cols) * T->size;
+		const int ci1 = std::min(ci0 + T->size, W) - 1, cj1 = std::min(cj0 + T->size, H) - 1;
+		for (int k = T->offsets[t]; k < T->offsets[t+1]; k += 1) {
+			const int *tri = &T->tris[3*T->items[k]];
+			double u[3], v[3], z[3];
+			for (int m = 0; m < 3; m += 1) {
+				u[m] = T->uv[2*tri[m]]; v[m] = T->uv[2*tri[m]+1];
+				z[m] = attributes(tri[m], channel);
+			}
+			// the plane through the three vertices.
+			const double det = (u[1]-u[0])*(v[2]-v[0]) - (u[2]-u[0])*(v[1]-v[0]);
+			if (det == 0.0) continue; // thinner than the cells : its neighbours cover it
+			const double gu = ((z[1]-z[0])*(v[2]-v[0]) - (z[2]-z[0])*(v[1]-v[0])) / det;
+			const double gv = ((u[1]-u[0])*(z[2]-z[0]) - (u[2]-u[0])*(z[1]-z[0])) / det;
+
+			const double vmin = std::min(v[0], std::min(v[1], v[2]));
+			const double vmax = std::max(v[0], std::max(v[1], v[2]));
+			const int j0 = (int) std::max((double) cj0, ceil(vmin));
+			const int j1 = (int) std::min((double) cj1, floor(vmax));
+			for (int j = j0; j <= j1; j += 1) {
+				double lo = std::numeric_limits<double>::infinity(), hi = -lo;
+				for (int m = 0; m < 3; m += 1)
+					crossEdge(u[m], v[m], u[(m+1)%3], v[(m+1)%3], j, lo, hi);
+				const int i0 = (int) std::max((double) ci0, ceil(lo));
+				const int i1 = (int) std::min((double) ci1, floor(hi));
+				float *row = &grid->z[(long) j*W];
+				const double zj = z[0] + gv*(j - v[0]);
+				for (int i = i0; i <= i1; i += 1)
+					row[i] = zj + gu*(i - u[0]);
+			}
+		}
+	}
+}
+
+
+/** Bins the triangles into tiles by their bounding boxes, then scan-converts
+ *  the tiles in parallel. */
+void Rasterizer::rasterize(RasterGrid &grid, bool time) {
+	const vector<Vector2dPtr> &point_ptrs = sub->point_ptrs;
+	grid.z.clear();
+	if (channel < 0 || channel >= sub->attributes.cols() || sub->attributes.rows() < point_ptrs.size()) {
+		cout << ">>> The sites have no attribute "<<channel<<" to rasterize. Skipping.\n";
+		return;
+	}
+	if (grid.width <= 0 || grid.height <= 0 || !(grid.lo.x() < grid.hi.x()) || !(grid.lo.y() < grid.hi.y())) {
+		cout << ">>> Empty raster grid. Skipping.\n";
+		return;
+	}
+	double tim = wallTime();
+	const int W = grid.width, H = grid.height;
+	RasterTiles T;
+	T.size = 64;
+	T.cols = (W + T.size - 1) / T.size;
+	T.rows = (H + T.size - 1) / T.size;
+	sub->triangles(T.tris);
+	const int F = T.tris.size() / 3, NT = T.cols * T.rows;
+	const double tim_list = wallTime() - tim;
+	tim = wallTime();
+
+	// the sites in cells, once : the triangles of an edge share its end points.
+	const double su = W / (grid.hi.x() - grid.lo.x()), sv = H / (grid.hi.y() - grid.lo.y());
+	T.uv.resize(2*point_ptrs.size());
+	for (int i = 0; i < point_ptrs.size(); i += 1) {
+		if (!point_ptrs[i]) continue;
+		T.uv[2*i]   = (point_ptrs[i]->x() - grid.lo.x()) * su - 0.5;
+		T.uv[2*i+1] = (grid.hi.y() - point_ptrs[i]->y()) * sv - 0.5;
+	}
+
+	// the tiles under the cells each triangle may cover : count, then fill.
+	vector<int> range(4*F);
+	T.offsets.assign(NT+1, 0);
+	for (int f = 0; f < F; f += 1) {
+		double u[3], v[3];
+		for (int m = 0; m < 3; m += 1) {
+			u[m] = T.uv[2*T.tris[3*f+m]]; v[m] = T.uv[2*T.tris[3*f+m]+1];
+		}
+		const double i0 = std::max(0.0, ceil(std::min(u[0], std::min(u[1], u[2]))));
+		const double i1 = std::min(W-1.0, floor(std::max(u[0], std::max(u[1], u[2]))));
+		const double j0 = std::max(0.0, ceil(std::min(v[0], std::min(v[1], v[2]))));
+		const double j1 = std::min(H-1.0, floor(std::max(v[0], std::max(v[1], v[2]))));
+		int *r = &range[4*f];
+		if (i0 > i1 || j0 > j1) { // off the grid, or between two cell centres
+			r[0] = 0; r[1] = -1; r[2] = 0; r[3] = -1;
+			continue;
+		}
+		r[0] = (int) i0 / T.size; r[1] = (int) i1 / T.size;
+		r[2] = (int) j0 / T.size; r[3] = (int) j1 / T.size;
+		for (int ty = r[2]; ty <= r[3]; ty += 1)
+			for (int tx = r[0]; tx <= r[1]; tx += 1)
+				T.offsets[ty*T.cols + tx + 1] += 1;
+	}
+	for (int t = 0; t < NT; t += 1) T.offsets[t+1] += T.offsets[t];
+	T.items.resize(T.offsets[NT]);
+	vector<int> fill(T.offsets.begin(), T.offsets.end() - 1);
+	for (int f = 0; f < F; f += 1) {
+		const int *r = &range[4*f];
+		for (int ty = r[2]; ty <= r[3]; ty += 1)
+			for (int tx = r[0]; tx <= r[1]; tx += 1)
+				T.items[fill[ty*T.cols + tx]++] = f;
+	}
+	grid.z.assign((long) W*H, std::numeric_limits<float>::quiet_NaN());
+	const double tim_bin = wallTime() - tim;
+
+	// tile t goes to thread t % P : the dense parts of the grid are shared.
+	tim = wallTime();
+	const int P = std::max(1, std::min(sub->num_threads, NT));
+	boost::thread_group workers;
+	for (int p = 1; p < P; p += 1)
+		workers.create_thread(boost::bind(&Rasterizer::rasterTiles, this, &T, p, P, &grid));
+	rasterTiles(&T, 0, P, &grid);
+	workers.join_all();
+
+	if (time) {
+		cout <<">>> rasterized "<<F<<" triangles onto "<<W<<" x "<<H<<" cells : "<<tim_list
+			 <<" seconds to list them, "<<tim_bin<<" seconds to bin them into "<<NT<<" tiles, "<<wallTime()-tim
+			 <<" seconds to scan-convert on "<<P<<" threads.\n";
+	}
+}
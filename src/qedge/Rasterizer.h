@@ -0,0 +1,64 @@
+/** Rasterization of a TIN : the linear interpolation of a vertex attribute
+ *  of a Delaunay triangulation, sampled at the centres of a regular grid.
+ *
+ *  The triangles are binned into square tiles, and the tiles are
+ *  scan-converted in parallel over num_threads threads, each writing only
+ *  its own tiles, so there are no locks. Each scan line of a triangle is
+ *  cut by its edges, worked out the same way by the two triangles of an
+ *  edge, so that the cells on an edge are not dropped. */
+
+#ifndef __RASTERIZER_H__
+#define __RASTERIZER_H__
+
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include "DelaunaySubdivision.h"
+
+
+/** A regular grid of WIDTH x HEIGHT cells over the box [LO, HI], row 0 at
+ *  the top (HI.y) : the value of cell (i, j), sampled at its centre, is
+ *  Z[j*WIDTH + i] (NaN outside the triangulation). */
+struct RasterGrid {
+	int width, height;
+	Eigen::Vector2d lo, hi;
+	std::vector<float> z;
+};
+
+
+/** The triangles of a subdivision binned by raster tile : tile t overlaps
+ *  the triangles TRIS[3k..3k+2] for the k in ITEMS[OFFSETS[t] ..
+ *  OFFSETS[t+1]-1]. The site v is at UV[2v], UV[2v+1] in cell coordinates,
+ *  where the centre of cell (i, j) is (i, j). */
+struct RasterTiles {
+	int size, cols, rows; // tile edge in cells, number of tiles across and down
+	std::vector<double> uv;
+	std::vector<int> tris;
+	std::vector<int> offsets;
+	std::vector<int> items;
+};
+
+
+class Rasterizer {
+public:
+	typedef boost::shared_ptr<Rasterizer> Ptr;
+
+	/** Rasterizes the attribute CHANNEL of SUB, which must be triangulated
+	 *  already. */
+	Rasterizer(DelaunaySubdivision *sub, int channel=0);
+
+	/** Fills GRID (its size and box must be set) : the value of each cell
+	 *  is the linear interpolation at its centre. GRID is left empty if the
+	 *  sites have no such attribute. With TIME, the time of each stage is
+	 *  printed. */
+	void rasterize(RasterGrid &grid, bool time=false);
+
+private:
+	DelaunaySubdivision *sub;
+	int channel;
+
+	/** Thread entry for rasterize : scan-converts the triangles of the
+	 *  tiles FIRST, FIRST+STRIDE, ... of T into GRID. */
+	void rasterTiles(const RasterTiles *T, int first, int stride, RasterGrid *grid);
+};
+
+#endif
@@ -0,0 +1,78 @@
+/** Euclidean minimum spanning tree from the Delaunay edges.
+ *  See SpanningTree.h */
+
+#include "SpanningTree.h"
+#include "utils/misc.h"
+#include "utils/sorting.h"
+#include <stdint.h>
+#include <iostream>
+
+using namespace Eigen;
+using namespace std;
+
+
+/** Root of the set of X, halving the path on the way. */
+static inline int findRoot(vector<int> &parent, int x) {
+	while (parent[x] != x) {
+		parent[x] = parent[parent[x]];
+		x = parent[x];
+	}
+	return x;
+}
+
+
+/** Kruskal's algorithm on the Delaunay edges, which hold the EMST :
+ *  the edges are radix sorted by squared length, and joined by a
+ *  union-find (by size, with path halving). */
+SpanningTree::SpanningTree(DelaunaySubdivision *sub, bool time) : length(0.0) {
+	if (!sub->randEdge) {
+		cout << "Spanning tree : compute the triangulation first. Exiting.\n";
+		exit(-1);
+	}
+	const vector<Vector2dPtr> &point_ptrs = sub->point_ptrs;
+	double tim = wallTime();
+	vector<int> ends;
+	vector<uint64_t> keys;
+	{
+		vector<QuadEdge::Ptr> qedges;
+		sub->collectQuadEdges(qedges);
+		ends.resize(2*qedges.size());
+		keys.resize(qedges.size());
+		for (int i = 0; i < qedges.size(); i += 1) {
+			Edge::Ptr e = qedges[i]->edges[0];
+			ends[2*i] = e->org(); ends[2*i+1] = e->dest();
+			keys[i] = radixKey((*point_ptrs[e->org()] - *point_ptrs[e->dest()]).squaredNorm());
+		}
+	}
+	const int E = keys.size();
+	const double tim_collect = wallTime() - tim;
+
+	tim = wallTime();
+	vector<int> order(E);
+	for (int i = 0; i < E; i += 1) order[i] = i;
+	radixSort(keys, order);
+	keys.clear(); keys.shrink_to_fit();
+	const double tim_sort = wallTime() - tim;
+
+	tim = wallTime();
+	vector<int> parent(point_ptrs.size()), size(point_ptrs.size(), 1);
+	for (int i = 0; i < parent.size(); i += 1) parent[i] = i;
+	int joins = 0;
+	const int n = sub->points.size();
+	for (int i = 0; i < E && joins < n-1; i += 1) {
+		const int a = ends[2*order[i]], b = ends[2*order[i]+1];
+		int ra = findRoot(parent, a), rb = findRoot(parent, b);
+		if (ra == rb) continue;
+		if (size[ra] < size[rb]) std::swap(ra, rb);
+		parent[rb] = ra;
+		size[ra] += size[rb];
+		edges.push_back(a); edges.push_back(b);
+		length += (*point_ptrs[a] - *point_ptrs[b]).norm();
+		joins += 1;
+	}
+	if (time) {
+		cout <<">>> emst : "<<tim_collect<<" seconds to collect "<<E<<" edges, "
+			 <<tim_sort<<" seconds to radix sort them, "<<wallTime()-tim<<" seconds for union-find.\n"
+			 <<">>> emst : "<<joins<<" edges, length "<<length<<".\n";
+	}
+}
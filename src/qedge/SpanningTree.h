@@ -0,0 +1,31 @@
+/** Euclidean minimum spanning tree of the sites of a Delaunay
+ *  triangulation, which holds it among its edges.
+ *
+ *  Kruskal's algorithm on the (unconstrained) Delaunay edges : they are
+ *  radix sorted by squared length and joined by a union-find, by size with
+ *  path halving. O(n log n) with the triangulation, O(n) after it. */
+
+#ifndef __SPANNING_TREE_H__
+#define __SPANNING_TREE_H__
+
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include "DelaunaySubdivision.h"
+
+
+class SpanningTree {
+public:
+	typedef boost::shared_ptr<SpanningTree> Ptr;
+
+	/** Computes the EMST of the sites of SUB, which must be triangulated
+	 *  already. With TIME, the time of each stage is printed. */
+	SpanningTree(DelaunaySubdivision *sub, bool time=false);
+
+	// the end points of the tree edges (2 per edge), shortest first.
+	std::vector<int> edges;
+
+	// the total length of the tree.
+	double length;
+};
+
+#endif
@@ -0,0 +1,425 @@
+/** Out-of-core Delaunay triangulation of a .node file, by vertical strips.
+ *  See StripDelaunay.h */
+
+#include "StripDelaunay.h"
+#include "utils/sorting.h"
+#include "utils/misc.h"
+#include <boost/random/mersenne_twister.hpp>
+#include <algorithm>
+#include <limits>
+#include <iostream>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+
+using namespace Eigen;
+using namespace std;
+
+
+/** Reads the next point of the .node file IN into R, skipping the blank
+ *  lines and the comments. Returns false at the end of the file. */
+static bool nextPoint(ifstream &in, StripRecord &r) {
+	string line;
+	while (getline(in, line)) {
+		const char *s = line.c_str();
+		while (*s == ' ' || *s == '\t') s += 1;
+		if (*s == '\0' || *s == '#' || *s == '\r') continue;
+		char *end;
+		r.id = strtoll(s, &end, 10);
+		r.x  = strtod(end, &end);
+		r.y  = strtod(end, &end);
+		return true;
+	}
+	return false;
+}
+
+
+/** Opens the .node file FNAME and reads its header into N. */
+static void openNodeFile(const string &fname, ifstream &in, long long &N) {
+	in.open(fname.c_str());
+	if (!in.is_open()) {
+		cout << "Unable to open file : " << fname << endl;
+		exit(-1);
+	}
+	StripRecord header; // <# of vertices> <dimension> ...
+	if (!nextPoint(in, header)) {
+		cout << "Empty .node file : " << fname << ". Exiting.\n";
+		exit(-1);
+	}
+	N = header.id;
+}
+
+
+StripDelaunay::StripDelaunay(const string &node_file_, const string &out_prefix_, long long strip_size_)
+	: node_file(node_file_), out_prefix(out_prefix_), strip_size(max(strip_size_, 3LL)),
+	  sub(vector<int>(), vector<Vector2dPtr>(), out_prefix_), peak_sites(0), num_triangles(0) {}
+
+
+/** The name of the file of strip K. */
+string StripDelaunay::stripName(int k) const {
+	stringstream name;
+	name << out_prefix << ".strip" << k;
+	return name.str();
+}
+
+
+/** First pass : counts the points, and cuts the strips at quantiles
+ *  of a reservoir sample of their x coordinates (Vitter [1985]). */
+long long StripDelaunay::sampleSplits() {
+	const int S = 1 << 16;
+	ifstream in;
+	long long N;
+	openNodeFile(node_file, in, N);
+
+	boost::mt19937 rng(274);
+	vector<double> sample;
+	sample.reserve(S);
+	StripRecord r;
+	long long n = 0;
+	while (nextPoint(in, r)) {
+		if (n < S) sample.push_back(r.x);
+		else {
+			const unsigned long long j = ((((unsigned long long) rng()) << 32) | rng()) % (n+1);
+			if (j < S) sample[j] = r.x;
+		}
+		n += 1;
+	}
+	if (n != N)
+		cout << ">>> Expecting "<< N << " points. Found "<<n<<" while reading "
+		     << node_file << ". Using them all."<< endl;
+
+	sort(sample.begin(), sample.end());
+	const long long K = max(1LL, (n + strip_size - 1) / strip_size);
+	splits.clear();
+	for (long long k = 1; k < K; k += 1)
+		splits.push_back(sample[(k * sample.size()) / K]);
+	splits.erase(unique(splits.begin(), splits.end()), splits.end());
+	return n;
+}
+
+
+/** Second pass : appends every point to the file of its strip.
+ *  The records are buffered per strip, in ~24 MB over all the strips. */
+void StripDelaunay::distribute() {
+	const int K = splits.size() + 1;
+	const double inf = numeric_limits<double>::infinity();
+	counts.assign(K, 0);
+	boxes.resize(4*K);
+	for (int k = 0; k < K; k += 1) {
+		boxes[4*k]   = boxes[4*k+1] =  inf;
+		boxes[4*k+2] = boxes[4*k+3] = -inf;
+		remove(stripName(k).c_str());
+	}
+
+	const int per_strip = max(64, (1 << 20) / K);
+	vector<vector<StripRecord> > buffers(K);
+	ifstream in;
+	long long N;
+	openNodeFile(node_file, in, N);
+
+	StripRecord r;
+	while (true) {
+		const bool more = nextPoint(in, r);
+		for (int k = 0; k < K; k += 1) {
+			if (buffers[k].empty() || (more && buffers[k].size() < per_strip)) continue;
+			const string name = stripName(k);
+			FILE *f = fopen(name.c_str(), "ab");
+			if (!f || fwrite(&buffers[k][0], sizeof(StripRecord), buffers[k].size(), f) != buffers[k].size()) {
+				cout << "Unable to write file : " << name << endl;
+				exit(-1);
+			}
+			fclose(f);
+			buffers[k].clear();
+		}
+		if (!more) break;
+
+		const int k = upper_bound(splits.begin(), splits.end(), r.x) - splits.begin();
+		buffers[k].push_back(r);
+		counts[k] += 1;
+		boxes[4*k]   = min(boxes[4*k],   r.x);
+		boxes[4*k+1] = min(boxes[4*k+1], r.y);
+		boxes[4*k+2] = max(boxes[4*k+2], r.x);
+		boxes[4*k+3] = max(boxes[4*k+3], r.y);
+	}
+}
+
+
+/** Reads the strips FIRST..LAST into new local sites, drops the
+ *  duplicates (the one first in the .node file is kept), and returns
+ *  their local indices sorted lexicographically. */
+void StripDelaunay::loadStrips(int first, int last, vector<int> &ids) {
+	ids.clear();
+	vector<StripRecord> records;
+	for (int k = first; k <= last; k += 1) {
+		if (!counts[k]) continue;
+		const string name = stripName(k);
+		FILE *f = fopen(name.c_str(), "rb");
+		records.resize(counts[k]);
+		if (!f || fread(&records[0], sizeof(StripRecord), counts[k], f) != counts[k]) {
+			cout << "Unable to read file : " << name << endl;
+			exit(-1);
+		}
+		fclose(f);
+		remove(name.c_str());
+
+		for (int i = 0; i < records.size(); i += 1) {
+			int v;
+			if (free_ids.size()) {
+				v = free_ids.back();
+				free_ids.pop_back();
+			} else {
+				v = sub.point_ptrs.size();
+				sub.point_ptrs.push_back(Vector2dPtr());
+				global.push_back(0);
+				ring_edge.push_back(Edge::Ptr());
+				active.push_back(0);
+				fresh.push_back(0);
+				seen.push_back(0);
+			}
+			sub.point_ptrs[v] = Vector2dPtr(new Vector2d(records[i].x, records[i].y));
+			global[v] = records[i].id;
+			ids.push_back(v);
+		}
+	}
+	peak_sites = max(peak_sites, (int) (sub.point_ptrs.size() - free_ids.size()));
+
+	lexicoSort(ids, &sub.point_ptrs, 0, ids.size()-1);
+	int m = 0;
+	for (int i = 0; i < ids.size(); i += 1) {
+		int v = ids[i];
+		if (m > 0 && *sub.point_ptrs[v] == *sub.point_ptrs[ids[m-1]]) {
+			if (global[v] < global[ids[m-1]]) std::swap(v, ids[m-1]);
+			freeSite(v);
+		} else {
+			ids[m++] = v;
+		}
+	}
+	ids.resize(m);
+	for (int i = 0; i < m; i += 1) fresh[ids[i]] = 1;
+}
+
+
+/** Points ring_edge of every site of the new strip, and of all their
+ *  neighbours, at a live edge. This is a search over the edges with an
+ *  end in the new strip, from START : the merge joins all of them. */
+void StripDelaunay::refreshRings(Edge::Ptr start) {
+	vector<Edge::Ptr> stack(1, start);
+	vector<int> visited;
+	while (stack.size()) {
+		Edge::Ptr e = stack.back();
+		stack.pop_back();
+		const int v = e->org();
+		if (seen[v]) continue;
+		seen[v] = 1;
+		visited.push_back(v);
+		ring_edge[v] = e;
+		Edge::Ptr f = e;
+		do {
+			const int w = f->dest();
+			ring_edge[w] = f->Sym();
+			if (!seen[w] && (fresh[v] || fresh[w])) stack.push_back(f->Sym());
+			f = f->Onext();
+		} while (f != e);
+	}
+	for (int i = 0; i < visited.size(); i += 1) seen[visited[i]] = 0;
+}
+
+
+/** The cut from which the ccw triangle A, B, C is final.
+ *  The circumcenter is computed from the vertex first in the .node file,
+ *  so that the result does not depend on the rotation. Its error is
+ *  O(eps R L^2 / area), for the circumradius R and the longest edge L. */
+double StripDelaunay::finalCut(int a, int b, int c) {
+	const double inf = numeric_limits<double>::infinity();
+	if (global[b] < global[a] && global[b] < global[c]) {
+		const int t = a; a = b; b = c; c = t;
+	} else if (global[c] < global[a] && global[c] < global[b]) {
+		const int t = c; c = b; b = a; a = t;
+	}
+	const Vector2d &pa = *sub.point_ptrs[a];
+	const Vector2d u = *sub.point_ptrs[b] - pa;
+	const Vector2d w = *sub.point_ptrs[c] - pa;
+	const double d = 2.0 * (u.x()*w.y() - u.y()*w.x());
+	if (!(d > 0.0)) return inf;
+	const double uu = u.squaredNorm(), ww = w.squaredNorm();
+	const Vector2d o((w.y()*uu - u.y()*ww) / d, (u.x()*ww - w.x()*uu) / d);
+	const double r  = o.norm();
+	const double L2 = max(max(uu, ww), (w - u).squaredNorm());
+	const double margin = 1e-13 * (fabs(pa.x()) + fabs(pa.y()) + r * (1.0 + 2.0*L2/d));
+	const double cut = pa.x() + o.x() + r + margin;
+	return std::isfinite(cut)? cut : inf;
+}
+
+
+/** Writes the final triangles around the live and the new sites.
+ *  Each triangle is taken once, at its first vertex (by local index)
+ *  which is looked at. */
+void StripDelaunay::emitFinal(Edge::Ptr hull, const vector<int> &ids,
+		double prev, double x, vector<int> &looked) {
+	const bool last = (x == numeric_limits<double>::infinity());
+	looked = ids;
+	for (int i = 0; i < live.size(); i += 1) {
+		if (fresh[live[i]]) continue;
+		fresh[live[i]] = 1;
+		looked.push_back(live[i]);
+	}
+	for (int i = 0; i < looked.size(); i += 1) active[looked[i]] = 0;
+
+	Edge::Ptr h = hull->Sym(); // the outer face on its left
+	do {
+		active[h->org()] = 1;
+		h = h->Lnext();
+	} while (h != hull->Sym());
+
+	for (int i = 0; i < looked.size(); i += 1) {
+		const int v = looked[i];
+		Edge::Ptr e = ring_edge[v];
+		if (!e || !e->qEdge() || e->org() != v) {
+			cout << "Out-of-core triangulation : lost the edges of site "<<global[v]<<". Exiting.\n";
+			exit(-1);
+		}
+		do {
+			Edge::Ptr n = e->Onext();
+			const int b = e->dest(), c = n->dest();
+			if (!(fresh[b] && b < v) && !(fresh[c] && c < v) && sub.leftFaceIsTriangle(e)) {
+				const double cut = finalCut(v, b, c);
+				if (cut < prev) {
+					// written at an earlier step.
+				} else if (last || cut < x) {
+					num_triangles += 1;
+					ele << num_triangles <<"\t"<<global[v]<<"\t"<<global[b]<<"\t"<<global[c]<<"\n";
+				} else {
+					active[v] = active[b] = active[c] = 1;
+				}
+			}
+			e = n;
+		} while (e != ring_edge[v]);
+	}
+
+	live.clear();
+	for (int i = 0; i < looked.size(); i += 1)
+		if (active[looked[i]]) live.push_back(looked[i]);
+}
+
+
+/** Retires the sites in LOOKED which are not active. */
+void StripDelaunay::retire(const vector<int> &looked) {
+	vector<Edge::Ptr> drop;
+	for (int i = 0; i < looked.size(); i += 1) {
+		const int v = looked[i];
+		if (active[v] || !sub.point_ptrs[v]) continue;
+		drop.clear();
+		Edge::Ptr e = ring_edge[v];
+		do {
+			if (!active[e->dest()]) drop.push_back(e);
+			e = e->Onext();
+		} while (e != ring_edge[v]);
+		for (int k = 0; k < drop.size(); k += 1) dropEdge(drop[k]);
+	}
+}
+
+
+/** Deletes the edge E, and frees its end points if they are left
+ *  without edges. */
+void StripDelaunay::dropEdge(Edge::Ptr e) {
+	const int a = e->org(), b = e->dest();
+	Edge::Ptr s  = e->Sym();
+	Edge::Ptr an = e->Onext(), bn = s->Onext();
+	const bool a_alone = (an == e), b_alone = (bn == s);
+	sub.deleteEdge(e);
+	if (a_alone) freeSite(a); else ring_edge[a] = an;
+	if (b_alone) freeSite(b); else ring_edge[b] = bn;
+}
+
+
+/** Gives the local site V back. */
+void StripDelaunay::freeSite(int v) {
+	sub.point_ptrs[v].reset();
+	ring_edge[v].reset();
+	active[v] = fresh[v] = 0;
+	free_ids.push_back(v);
+}
+
+
+/** Runs the two passes and the sweep. */
+long long StripDelaunay::run(bool time) {
+	const double inf = numeric_limits<double>::infinity();
+	double tim = wallTime();
+	const long long N = sampleSplits();
+	const double tim_sample = wallTime() - tim;
+
+	tim = wallTime();
+	distribute();
+	const double tim_distribute = wallTime() - tim;
+
+	// the strips are grouped till each group has two distinct points :
+	// its bounding box is not a single point. A flat tail joins the last group.
+	const int K = counts.size();
+	vector<pair<int,int> > groups;
+	for (int k = 0, first = 0; k < K; k += 1) {
+		double lo[2] = {inf, inf}, hi[2] = {-inf, -inf};
+		for (int j = first; j <= k; j += 1) {
+			for (int i = 0; i < 2; i += 1) {
+				lo[i] = min(lo[i], boxes[4*j+i]);
+				hi[i] = max(hi[i], boxes[4*j+2+i]);
+			}
+		}
+		if (lo[0] < hi[0] || lo[1] < hi[1]) {
+			groups.push_back(make_pair(first, k));
+			first = k+1;
+		} else if (k == K-1 && groups.size()) {
+			groups.back().second = k;
+		}
+	}
+	if (groups.empty()) {
+		cout << "Out-of-core triangulation : expecting at least 2 distinct points. Exiting.\n";
+		exit(-1);
+	}
+
+	const string fname = out_prefix+".ele";
+	ele.open(fname.c_str(), ios::out);
+	if (!ele.is_open()) {
+		cout << "Unable to open file : " << fname << endl;
+		exit(-1);
+	}
+	ele << string(40, ' ') << "\n"; // the header, once the count is known
+
+	tim = wallTime();
+	pair<Edge::Ptr, Edge::Ptr> handles;
+	vector<int> ids, looked;
+	double prev = -inf;
+	for (int g = 0; g < groups.size(); g += 1) {
+		loadStrips(groups[g].first, groups[g].second, ids);
+		sub.points = ids;
+		pair<Edge::Ptr, Edge::Ptr> strip = sub.divideConquerVerticalCuts(0, ids.size()-1);
+		if (g == 0) {
+			handles = strip;
+			refreshRings(handles.first);
+		} else {
+			Edge::Ptr lower;
+			handles = sub.mergeTriangulations(handles, strip, &lower);
+			refreshRings(lower);
+		}
+
+		const double x = (g+1 < groups.size())? splits[groups[g].second] : inf;
+		emitFinal(handles.first, ids, prev, x, looked);
+		retire(looked);
+		for (int i = 0; i < looked.size(); i += 1) fresh[looked[i]] = 0;
+		prev = x;
+	}
+	sub.points.clear();
+	const double tim_sweep = wallTime() - tim;
+
+	ele.seekp(0);
+	ele << num_triangles << "\t" << 3 << "\t" << 0;
+	ele.close();
+	if (time) {
+		cout <<">>> out-of-core : "<<tim_sample<<" seconds to sample "<<N<<" points, "
+			 <<tim_distribute<<" seconds to write "<<K<<" strips.\n";
+		cout <<">>> out-of-core : "<<tim_sweep<<" seconds to triangulate "<<groups.size()
+			 <<" strips, at most "<<peak_sites<<" sites in memory.\n";
+	}
+	cout << "Wrote "<<fname<<endl;
+	return num_triangles;
+}
@@ -0,0 +1,123 @@
+/** Out-of-core Delaunay triangulation of a .node file, by vertical strips.
+ *
+ *  The points are never all in memory. Two streaming passes over the
+ *  .node file sort them into vertical strips on disk : the first counts
+ *  them and samples their x coordinates, the second appends each point,
+ *  as a binary record, to the file of its strip (cut at x quantiles of the
+ *  sample). The strips are then triangulated left to right with the
+ *  vertical cuts divide-and-conquer, and each one is stitched to the
+ *  triangulation of the strips before it by mergeTriangulations.
+ *
+ *  A triangle whose circumcircle lies strictly to the left of the next
+ *  strip can not be in conflict with any point still to come : it is final,
+ *  and is written to the .ele file right away. A vertex all of whose
+ *  triangles are written, and which is not on the convex hull, is retired;
+ *  the edges between retired vertices are deleted, and a vertex left
+ *  without edges is freed. Its local index is reused by a later strip.
+ *  What stays in memory is the triangles whose circumcircles reach past
+ *  the last strip, the written ones around them, and the convex hull : a
+ *  few strips' worth for evenly spread points.
+ *
+ *  Each step only looks at the live vertices (those of the triangles not
+ *  written yet, and of the hull) and at the new strip : a merge only makes
+ *  triangles with a vertex in the new strip, and the triangles it destroys
+ *  are not final. The test for final is computed the same way at every
+ *  step, so a triangle is written at the first cut it passes, once. */
+
+#ifndef __STRIP_DELAUNAY_H__
+#define __STRIP_DELAUNAY_H__
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include "DelaunaySubdivision.h"
+
+
+/** A point in a strip file : its index in the .node file and coordinates. */
+struct StripRecord {
+	long long id;
+	double    x, y;
+};
+
+
+class StripDelaunay {
+public:
+	/** Triangulates the .node file NODE_FILE into OUT_PREFIX.ele, with
+	 *  about STRIP_SIZE points per strip. The strip files are written next
+	 *  to the output, as OUT_PREFIX.strip<k>, and removed once read. */
+	StripDelaunay(const std::string &node_file, const std::string &out_prefix, long long strip_size);
+
+	/** Runs the two passes and the sweep. With TIME, the time of each
+	 *  stage and the peak number of sites in memory are printed.
+	 *  Returns the number of triangles written. */
+	long long run(bool time=false);
+
+private:
+	std::string node_file, out_prefix;
+	long long strip_size;
+
+	// the engine : local indices into its point_ptrs, reused once freed.
+	DelaunaySubdivision sub;
+	std::vector<long long> global;    // .node index of each local site
+	std::vector<Edge::Ptr> ring_edge; // an edge out of each local site
+	std::vector<char>      active;    // has a triangle not written yet, or is on the hull
+	std::vector<char>      fresh;     // scratch : in the current strip, or looked at in this step
+	std::vector<char>      seen;      // scratch : visited by refreshRings
+	std::vector<int>       live;      // the active sites after the last step
+	std::vector<int>       free_ids;
+	int peak_sites;
+
+	// the strips : cut at the x values of splits, strip k is
+	// [splits[k-1], splits[k]). Their sizes and bounding boxes.
+	std::vector<double>    splits;
+	std::vector<long long> counts;
+	std::vector<double>    boxes; // 4 per strip : min x, min y, max x, max y
+
+	std::ofstream ele;
+	long long num_triangles;
+
+	/** The name of the file of strip K. */
+	std::string stripName(int k) const;
+
+	/** First pass : counts the points, and cuts the strips at quantiles
+	 *  of a reservoir sample of their x coordinates. */
+	long long sampleSplits();
+
+	/** Second pass : appends every point to the file of its strip. */
+	void distribute();
+
+	/** Reads the strips FIRST..LAST into new local sites, drops the
+	 *  duplicates, and returns their local indices sorted lexicographically. */
+	void loadStrips(int first, int last, std::vector<int> &ids);
+
+	/** Points ring_edge of every site of the new strip, and of all their
+	 *  neighbours, at a live edge : a merge deletes only edges between
+	 *  sites which it then joins to the new strip. START is out of a new site. */
+	void refreshRings(Edge::Ptr start);
+
+	/** Writes the triangles at the live sites and at the new sites IDS
+	 *  which are final for the cut X (all of them if X is infinite) and
+	 *  were not for PREV. Marks the vertices of the others, and those of the
+	 *  hull, active. HULL is a ccw hull edge. Returns the sites looked at. */
+	void emitFinal(Edge::Ptr hull, const std::vector<int> &ids,
+			double prev, double x, std::vector<int> &looked);
+
+	/** Retires the sites in LOOKED which are not active : deletes their
+	 *  edges to other retired sites, and frees those left with none. */
+	void retire(const std::vector<int> &looked);
+
+	/** Deletes the edge E, and frees its end points if they are left
+	 *  without edges. */
+	void dropEdge(Edge::Ptr e);
+
+	/** Gives the local site V back. */
+	void freeSite(int v);
+
+	/** The cut from which the ccw triangle A, B, C is final : the right end
+	 *  of its circumcircle, rounded up by a margin which grows with the
+	 *  aspect of the triangle (infinite if it is too flat). The same for
+	 *  any rotation of A, B, C. */
+	double finalCut(int a, int b, int c);
+};
+
+#endif
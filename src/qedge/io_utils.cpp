@@ -9,6 +9,10 @@
 #include <iostream>
 #include <fstream>
 #include <stdlib.h>
+#include <stdint.h>
+#include <cstring>
+#include <iterator>
+#include <cmath>
 #include <Eigen/Dense>
 #include <boost/lexical_cast.hpp>
 #include <boost/unordered_set.hpp>
@@ -22,12 +26,14 @@ using namespace std;
 /** Reads a .node file specifying 2-dimension points
  *  into a vector of pointers to Eigen::Vector2d points.*/
 void readNodeFile(const std::string &fname,
-		std::vector<int> &pts, std::vector<Vector2dPtr> &point_ptrs) {
+		std::vector<int> &pts, std::vector<Vector2dPtr> &point_ptrs,
+		ColMatrixXd *attributes) {
 
 	bool readFirstLine        = false;
 	unsigned int N           = -1;
 	unsigned int dim         = -1;
 	unsigned int i           =  0;
+	int num_attr             =  0;
 
 	ifstream inpfile(fname.c_str());
 	if(!inpfile.is_open()) {
@@ -58,6 +64,10 @@ void readNodeFile(const std::string &fname,
 				assert(("Dimension of vertices must be 2", dim==2));
 				pts.clear(); point_ptrs.clear();
 				pts.resize(N); point_ptrs.resize(N+1);
+				if (attributes) {
+					num_attr = (splitline.size() > 2)? atoi(splitline[2].c_str()) : 0;
+					attributes->setZero(N+1, num_attr);
+				}
 				i = 0;
 				readFirstLine = true;
 			} else { // read the vertices
@@ -71,6 +81,8 @@ void readNodeFile(const std::string &fname,
 				if (i < N) {
 					pts[i]            = index;
 					point_ptrs[index] = Vector2dPtr(new Vector2d(x,y));
+					for (int k = 0; k < num_attr && 3+k < splitline.size(); k += 1)
+						(*attributes)(index, k) = atof(splitline[3+k].c_str());
 					i += 1;
 				} else {
 					cout << ">>> Expecting "<< N << " points. Found more while reading "
@@ -82,6 +94,105 @@ void readNodeFile(const std::string &fname,
 }
 
 
+void readPolyFile(const std::string &fname, std::vector<int> &pts,
+		std::vector<Vector2dPtr> &point_ptrs, std::vector<std::pair<int, int> > &segments,
+		ColMatrixXd *attributes) {
+	ifstream inpfile(fname.c_str());
+	if(!inpfile.is_open()) {
+		cout << "Unable to open file : " << fname << endl;
+		exit(-1);
+	}
+	// the non-blank, non-comment lines, split on white-space, and their
+	// line numbers in the file.
+	vector<vector<string> > lines;
+	vector<int> line_nums;
+	for (int num = 1; !inpfile.eof(); num += 1) {
+		string line;
+		getline(inpfile,line);
+		line = line.substr(0, line.find('#'));
+		vector<string> splitline;
+		string buf;
+		stringstream ss(line);
+		while (ss >> buf)
+			splitline.push_back(buf);
+		if (splitline.size()) {
+			lines.push_back(splitline);
+			line_nums.push_back(num);
+		}
+	}
+	inpfile.close();
+
+	if (lines.empty() || lines[0].size() < 2 || atoi(lines[0][1].c_str()) != 2) {
+		cout << "First line of .poly should be : <# of vertices> <dimension (must be 2)> "
+				"<# of attributes> <# of boundary markers (0 or 1)>. Exiting.\n";
+		exit(-1);
+	}
+	const int N = atoi(lines[0][0].c_str());
+	int l = 1;
+	if (N == 0) {
+		readNodeFile(fname.substr(0, fname.length()-5)+".node", pts, point_ptrs, attributes);
+	} else {
+		if (lines.size() < N+1) {
+			cout << "Expecting "<< N << " vertices in "<<fname<<". Exiting.\n";
+			exit(-1);
+		}
+		// parse the vertices first : the indices size point_ptrs.
+		vector<int> index(N);
+		vector<double> xy(2*N);
+		int max_index = 0;
+		for (int i = 0; i < N; i += 1) {
+			const vector<string> &v = lines[1+i];
+			try {
+				if (v.size() < 3) throw boost::bad_lexical_cast();
+				index[i]  = boost::lexical_cast<int>(v[0]);
+				xy[2*i]   = boost::lexical_cast<double>(v[1]);
+				xy[2*i+1] = boost::lexical_cast<double>(v[2]);
+			} catch (const boost::bad_lexical_cast &) {
+				cout << "Bad vertex on line "<<line_nums[1+i]<<" of "<<fname<<". Vertices should be "
+						"specified as : <vertex #> <x> <y> [attributes] [boundary marker]. Exiting.\n";
+				exit(-1);
+			}
+			if (index[i] < 0) {
+				cout << "Negative vertex index on line "<<line_nums[1+i]<<" of "<<fname<<". Exiting.\n";
+				exit(-1);
+			}
+			max_index = std::max(max_index, index[i]);
+		}
+		pts.resize(N); point_ptrs.assign(max_index+1, Vector2dPtr());
+		const int num_attr = (lines[0].size() > 2)? atoi(lines[0][2].c_str()) : 0;
+		if (attributes) attributes->setZero(max_index+1, num_attr);
+		for (int i = 0; i < N; i += 1, l += 1) {
+			pts[i]               = index[i];
+			point_ptrs[index[i]] = Vector2dPtr(new Vector2d(xy[2*i], xy[2*i+1]));
+			for (int k = 0; attributes && k < num_attr && 3+k < lines[l].size(); k += 1)
+				(*attributes)(index[i], k) = atof(lines[l][3+k].c_str());
+		}
+	}
+
+	segments.clear();
+	if (l >= lines.size()) return;
+	const int S = atoi(lines[l++][0].c_str());
+	for (int i = 0; i < S && l < lines.size(); i += 1, l += 1) {
+		int a, b;
+		try {
+			if (lines[l].size() < 3) throw boost::bad_lexical_cast();
+			a = boost::lexical_cast<int>(lines[l][1]);
+			b = boost::lexical_cast<int>(lines[l][2]);
+		} catch (const boost::bad_lexical_cast &) {
+			cout << ">>> Bad segment on line "<<line_nums[l]<<" of "<<fname<<". Segments should be "
+					"specified as : <segment #> <endpoint> <endpoint> [boundary marker]. Skipping.\n";
+			continue;
+		}
+		if (a < 0 || b < 0 || a >= point_ptrs.size() || b >= point_ptrs.size()
+				|| !point_ptrs[a] || !point_ptrs[b]) {
+			cout << ">>> Segment "<<lines[l][0]<<" of "<<fname<<" has no such vertex. Skipping.\n";
+			continue;
+		}
+		segments.push_back(std::make_pair(a, b));
+	}
+}
+
+
 void reportTriangle(Edge::Ptr e, DelaunaySubdivision* subD,
 		int check_num, std::vector<std::vector<int> >  &tris) {
 
@@ -152,6 +263,12 @@ void writeSubdivision(const std::string &fname, DelaunaySubdivision* subD) {
 		reportTriangle(q->edges[0]->Sym(), subD, 0, tris);
 	}
 
+	// clear the marks, so that the subdivision can be written again after an edit.
+	for(int i=0; i < qedges.size(); i+=1) {
+		qedges[i]->visit_num = 0;
+		for (int k=0; k < 4; k+=1) qedges[i]->edges[k]->visit_num = 0;
+	}
+
 	ofstream outfile;
 	outfile.open(fname.c_str(), ios::out);
 	outfile << tris.size()<<"\t"<<3<<"\t"<<0<<endl;
@@ -160,3 +277,343 @@ void writeSubdivision(const std::string &fname, DelaunaySubdivision* subD) {
 	outfile.close();
 	cout << "Wrote "<<fname<<endl;
 }
+
+
+/** Writes the answers of DelaunaySubdivision::locateAll to fname.*/
+void writeLocations(const std::string &fname, const std::vector<int> &ids,
+		const std::vector<Edge::Ptr> &result, DelaunaySubdivision* subD) {
+	ofstream outfile;
+	outfile.open(fname.c_str(), ios::out);
+	outfile << ids.size()<<"\t"<<3<<endl;
+	for (int i=0; i < ids.size(); i+=1) {
+		Edge::Ptr e = result[i];
+		if (subD->leftFaceIsTriangle(e))
+			outfile <<ids[i]<<"\t"<<e->org()<<"\t"<<e->dest()<<"\t"<<e->Lprev()->org()<<"\n";
+		else
+			outfile <<ids[i]<<"\t"<<-1<<"\t"<<-1<<"\t"<<-1<<"\n";
+	}
+	outfile.close();
+	cout << "Wrote "<<fname<<endl;
+}
+
+
+void writeInterpolation(const std::string &fname, const std::vector<int> &ids,
+		const RowMatrixXd &values) {
+	ofstream outfile;
+	outfile.open(fname.c_str(), ios::out);
+	outfile.precision(17);
+	outfile << ids.size()<<"\t"<<values.cols()<<endl;
+	for (int i=0; i < ids.size(); i+=1) {
+		outfile << ids[i];
+		for (int k=0; k < values.cols(); k+=1)
+			outfile <<"\t"<<values(i,k);
+		outfile <<"\n";
+	}
+	outfile.close();
+	cout << "Wrote "<<fname<<endl;
+}
+
+
+void packContours(const Contours &lines, std::vector<char> &buffer) {
+	const int32_t k = lines.levels.size(), p = lines.level.size(), m = lines.coords.size() / 2;
+	buffer.resize(3*sizeof(int32_t) + k*sizeof(double) + (2*p+1)*sizeof(int32_t) + 2*m*sizeof(double));
+	char *out = &buffer[0];
+	memcpy(out, &k, sizeof(k)); out += sizeof(k);
+	memcpy(out, &p, sizeof(p)); out += sizeof(p);
+	memcpy(out, &m, sizeof(m)); out += sizeof(m);
+	if (k) memcpy(out, &lines.levels[0], sizeof(double) * k);
+	out += sizeof(double) * k;
+	if (p) memcpy(out, &lines.level[0], sizeof(int32_t) * p);
+	out += sizeof(int32_t) * p;
+	memcpy(out, &lines.offsets[0], sizeof(int32_t) * (p+1));
+	out += sizeof(int32_t) * (p+1);
+	if (m) memcpy(out, &lines.coords[0], sizeof(double) * 2*m);
+}
+
+
+void writeContourFile(const std::string &fname, const Contours &lines) {
+	vector<char> buffer;
+	packContours(lines, buffer);
+	ofstream outfile;
+	outfile.open(fname.c_str(), ios::out | ios::binary);
+	outfile.write(&buffer[0], buffer.size());
+	outfile.close();
+	cout << "Wrote "<<fname<<endl;
+}
+
+
+void writeRaster(const std::string &fname, const RasterGrid &grid) {
+	ofstream outfile(fname.c_str(), ios::out | ios::binary);
+	outfile.write((const char*) &grid.z[0], grid.z.size()*sizeof(float));
+	outfile.close();
+	cout << "Wrote "<<fname<<" ("<<grid.width<<" x "<<grid.height<<" floats)"<<endl;
+}
+
+
+void writePGM(const std::string &fname, const RasterGrid &grid) {
+	float zmin = 0.0f, zmax = 0.0f;
+	bool any = false;
+	for (long k = 0; k < grid.z.size(); k += 1) {
+		if (std::isnan(grid.z[k])) continue;
+		if (!any || grid.z[k] < zmin) zmin = grid.z[k];
+		if (!any || grid.z[k] > zmax) zmax = grid.z[k];
+		any = true;
+	}
+	const double scale = (zmax > zmin)? 65534.0 / (zmax - zmin) : 0.0;
+
+	ofstream outfile(fname.c_str(), ios::out | ios::binary);
+	outfile.precision(17);
+	outfile << "P5\n# box "<<grid.lo.x()<<" "<<grid.lo.y()<<" "<<grid.hi.x()<<" "<<grid.hi.y()
+			<<" z "<<zmin<<" "<<zmax<<"\n"<<grid.width<<" "<<grid.height<<"\n65535\n";
+	vector<unsigned char> row(2*grid.width);
+	for (int j = 0; j < grid.height; j += 1) {
+		for (int i = 0; i < grid.width; i += 1) {
+			const float z = grid.z[(long) j*grid.width + i];
+			const int g = std::isnan(z)? 0 : 1 + (int) floor((z - zmin)*scale + 0.5);
+			row[2*i] = g >> 8; row[2*i+1] = g & 0xff; // most significant byte first
+		}
+		outfile.write((const char*) &row[0], row.size());
+	}
+	outfile.close();
+	cout << "Wrote "<<fname<<endl;
+}
+
+
+void writeNodeFile(const std::string &fname, DelaunaySubdivision* subD) {
+	int N = 0;
+	for (int i=0; i < subD->point_ptrs.size(); i+=1)
+		if (subD->point_ptrs[i]) N += 1;
+	ofstream outfile;
+	outfile.open(fname.c_str(), ios::out);
+	outfile.precision(17);
+	outfile << N<<"\t"<<2<<"\t"<<0<<"\t"<<0<<endl;
+	for (int i=0; i < subD->point_ptrs.size(); i+=1)
+		if (subD->point_ptrs[i])
+			outfile <<i<<"\t"<<subD->point_ptrs[i]->x()<<"\t"<<subD->point_ptrs[i]->y()<<"\n";
+	outfile.close();
+	cout << "Wrote "<<fname<<endl;
+}
+
+
+void writeEdgeFile(const std::string &fname, const std::vector<int> &edges) {
+	ofstream outfile;
+	outfile.open(fname.c_str(), ios::out);
+	outfile << edges.size()/2<<"\t"<<0<<endl;
+	for (int i=0; 2*i < edges.size(); i+=1)
+		outfile <<i+1<<"\t"<<edges[2*i]<<"\t"<<edges[2*i+1]<<"\n";
+	outfile.close();
+	cout << "Wrote "<<fname<<endl;
+}
+
+
+void writeGraph(const std::string &fname, const CSRGraph &graph) {
+	vector<int> edges;
+	edges.reserve(graph.targets.size());
+	for (int v=0; v+1 < graph.offsets.size(); v+=1)
+		for (int j=graph.offsets[v]; j < graph.offsets[v+1]; j+=1)
+			if (v < graph.targets[j]) {
+				edges.push_back(v);
+				edges.push_back(graph.targets[j]);
+			}
+	writeEdgeFile(fname, edges);
+}
+
+
+void packCSR(const CSRGraph &graph, std::vector<char> &buffer) {
+	const int32_t n = graph.offsets.size() - 1, m = graph.targets.size();
+	buffer.resize(sizeof(int32_t) * (2 + (n+1) + m));
+	char *out = &buffer[0];
+	memcpy(out, &n, sizeof(n)); out += sizeof(n);
+	memcpy(out, &m, sizeof(m)); out += sizeof(m);
+	if (n+1) memcpy(out, &graph.offsets[0], sizeof(int32_t) * (n+1));
+	out += sizeof(int32_t) * (n+1);
+	if (m) memcpy(out, &graph.targets[0], sizeof(int32_t) * m);
+}
+
+
+void writeCSRFile(const std::string &fname, const CSRGraph &graph) {
+	vector<char> buffer;
+	packCSR(graph, buffer);
+	ofstream outfile;
+	outfile.open(fname.c_str(), ios::out | ios::binary);
+	outfile.write(&buffer[0], buffer.size());
+	outfile.close();
+	cout << "Wrote "<<fname<<endl;
+}
+
+
+void packTriangulation(std::pair<Edge::Ptr, Edge::Ptr> handles, std::vector<char> &buffer) {
+	// number the quad-edges, in the order of a search from the handle.
+	boost::unordered_map<QuadEdge*, int32_t> index;
+	vector<Edge::Ptr> quads(1, handles.first->qEdge()->edges[0]);
+	index[handles.first->qEdge().get()] = 0;
+	for (int q = 0; q < quads.size(); q += 1) {
+		Edge::Ptr nbrs[2] = {quads[q]->Onext(), quads[q]->Sym()->Onext()};
+		for (int i = 0; i < 2; i += 1) {
+			if (index.insert(make_pair(nbrs[i]->qEdge().get(), (int32_t) quads.size())).second)
+				quads.push_back(nbrs[i]->qEdge()->edges[0]);
+		}
+	}
+
+	const int32_t E = quads.size();
+	vector<int32_t> words(3 + 4*E);
+	Edge::Ptr ends[2] = {handles.first, handles.second};
+	for (int i = 0; i < 2; i += 1)
+		words[1+i] = 2*index[ends[i]->qEdge().get()] + (ends[i] == ends[i]->qEdge()->edges[0]? 0 : 1);
+	words[0] = E;
+	int32_t *orgs = &words[3], *onexts = &words[3 + 2*E];
+	for (int q = 0; q < E; q += 1) {
+		Edge::Ptr d[2] = {quads[q], quads[q]->Sym()};
+		for (int i = 0; i < 2; i += 1) {
+			Edge::Ptr n = d[i]->Onext();
+			orgs[2*q+i]   = d[i]->org();
+			onexts[2*q+i] = 2*index[n->qEdge().get()] + (n == n->qEdge()->edges[0]? 0 : 1);
+		}
+	}
+	buffer.resize(sizeof(int32_t) * words.size());
+	memcpy(&buffer[0], &words[0], buffer.size());
+}
+
+
+std::pair<Edge::Ptr, Edge::Ptr> unpackTriangulation(const char *buffer, size_t size) {
+	int32_t E = -1;
+	if (size >= sizeof(int32_t)) memcpy(&E, buffer, sizeof(E));
+	if (E < 1 || size != sizeof(int32_t) * (3 + 4*(size_t) E)) {
+		cout << "Corrupt triangulation buffer. Exiting.\n";
+		exit(-1);
+	}
+	vector<int32_t> words(3 + 4*E);
+	memcpy(&words[0], buffer, size);
+	const int32_t *orgs = &words[3], *onexts = &words[3 + 2*E];
+
+	vector<Edge::Ptr> d(2*E);
+	for (int q = 0; q < E; q += 1) {
+		d[2*q]   = QuadEdge::makeEdge();
+		d[2*q+1] = d[2*q]->Sym();
+		d[2*q]->setOrg(orgs[2*q]);
+		d[2*q]->setDest(orgs[2*q+1]);
+	}
+	// each ring of Onext, spliced in one edge at a time : the splices
+	// keep the dual (face) rings consistent.
+	vector<char> placed(2*E, 0);
+	for (int i = 0; i < 2*E; i += 1) {
+		if (placed[i]) continue;
+		placed[i] = 1;
+		for (int cur = i, next = onexts[i]; next != i; cur = next, next = onexts[cur]) {
+			if (next < 0 || next >= 2*E || placed[next]) {
+				cout << "Corrupt triangulation buffer. Exiting.\n";
+				exit(-1);
+			}
+			Edge::splice(d[cur], d[next]);
+			placed[next] = 1;
+		}
+	}
+	return make_pair(d[words[1]], d[words[2]]);
+}
+
+
+void writeTriangulationFile(const std::string &fname, std::pair<Edge::Ptr, Edge::Ptr> handles) {
+	vector<char> buffer;
+	packTriangulation(handles, buffer);
+	ofstream outfile;
+	outfile.open(fname.c_str(), ios::out | ios::binary);
+	outfile.write(&buffer[0], buffer.size());
+	outfile.close();
+	if (!outfile) {
+		cout << "Unable to write file : " << fname << endl;
+		exit(-1);
+	}
+}
+
+
+std::pair<Edge::Ptr, Edge::Ptr> readTriangulationFile(const std::string &fname) {
+	ifstream inpfile(fname.c_str(), ios::in | ios::binary);
+	if (!inpfile.is_open()) {
+		cout << "Unable to open file : " << fname << endl;
+		exit(-1);
+	}
+	vector<char> buffer((istreambuf_iterator<char>(inpfile)), istreambuf_iterator<char>());
+	return unpackTriangulation(buffer.empty()? NULL : &buffer[0], buffer.size());
+}
+
+
+void writeAlphaShape(const std::string &fname, const std::vector<int> &edges, int regular) {
+	ofstream outfile;
+	outfile.open(fname.c_str(), ios::out);
+	outfile << edges.size()/2<<"\t"<<1<<endl;
+	for (int i=0; 2*i < edges.size(); i+=1)
+		outfile <<i+1<<"\t"<<edges[2*i]<<"\t"<<edges[2*i+1]<<"\t"<<(i < regular? 1 : 0)<<"\n";
+	outfile.close();
+	cout << "Wrote "<<fname<<endl;
+}
+
+
+void writeHull(const std::string &fname, const std::vector<int> &hull) {
+	ofstream outfile;
+	outfile.open(fname.c_str(), ios::out);
+	outfile << hull.size()<<endl;
+	for (int i=0; i < hull.size(); i+=1)
+		outfile <<i+1<<"\t"<<hull[i]<<"\n";
+	outfile.close();
+	cout << "Wrote "<<fname<<endl;
+}
+
+
+void writeVoronoi(const std::string &fname, DelaunaySubdivision* subD) {
+	const int F = subD->computeVoronoi();
+
+	ofstream outfile;
+	outfile.open((fname+".v.node").c_str(), ios::out);
+	outfile.precision(17);
+	outfile << F<<"\t"<<2<<"\t"<<0<<"\t"<<0<<endl;
+	for (int f=0; f < F; f+=1)
+		outfile <<f+1<<"\t"<<subD->voronoi_vertices(f,0)<<"\t"<<subD->voronoi_vertices(f,1)<<"\n";
+	outfile.close();
+
+	// one Voronoi edge per Delaunay edge : e->Rot() goes from the right
+	// face of e to its left face.
+	vector<QuadEdge::Ptr> qedges;
+	subD->collectQuadEdges(qedges);
+	outfile.open((fname+".v.edge").c_str(), ios::out);
+	outfile.precision(17);
+	outfile << qedges.size()<<"\t"<<0<<endl;
+	for (int i=0; i < qedges.size(); i+=1) {
+		Edge::Ptr e = qedges[i]->edges[0];
+		int l = e->RotInv()->org(), r = e->Rot()->org();
+		if (l < 0) { e = e->Sym(); swap(l, r); }
+		outfile <<i+1<<"\t";
+		if (l < 0) { // both faces are outer : a hull with no triangle
+			outfile <<-1<<"\t"<<-1<<"\n";
+		} else if (r < 0) { // e has the outer face on its right
+			const Vector2d d = *subD->point_ptrs[e->dest()] - *subD->point_ptrs[e->org()];
+			outfile <<l+1<<"\t"<<-1<<"\t"<<d.y()<<"\t"<<-d.x()<<"\n";
+		} else {
+			outfile <<r+1<<"\t"<<l+1<<"\n";
+		}
+	}
+	outfile.close();
+
+	Vector2d lo(HUGE_VAL, HUGE_VAL), hi(-HUGE_VAL, -HUGE_VAL);
+	for (int i=0; i < subD->points.size(); i+=1) {
+		if (!subD->point_ptrs[subD->points[i]]) continue;
+		lo = lo.cwiseMin(*subD->point_ptrs[subD->points[i]]);
+		hi = hi.cwiseMax(*subD->point_ptrs[subD->points[i]]);
+	}
+	const Vector2d pad = 0.1*(hi - lo);
+	lo -= pad; hi += pad;
+
+	vector<int> sites, offsets;
+	vector<double> coords;
+	subD->voronoiCells(lo, hi, sites, offsets, coords);
+	outfile.open((fname+".v.cell").c_str(), ios::out);
+	outfile.precision(17);
+	outfile << sites.size()<<endl;
+	for (int i=0; i < sites.size(); i+=1) {
+		outfile <<sites[i]<<"\t"<<offsets[i+1]-offsets[i];
+		for (int j=offsets[i]; j < offsets[i+1]; j+=1)
+			outfile <<"\t"<<coords[2*j]<<"\t"<<coords[2*j+1];
+		outfile <<"\n";
+	}
+	outfile.close();
+	cout << "Wrote "<<fname<<".v.{node,edge,cell}"<<endl;
+}
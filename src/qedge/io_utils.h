@@ -11,6 +11,9 @@
 #include <string>
 #include <Eigen/AlignedVector>
 #include "DelaunaySubdivision.h"
+#include "DelaunayGraph.h"
+#include "Rasterizer.h"
+#include "ContourTracer.h"
 
 #include <boost/shared_ptr.hpp>
 #include <boost/unordered_map.hpp>
@@ -24,9 +27,22 @@
  *
  *  Also stores against the pointer of each point, its
  *  index in the node file. This is useful in writing the .ele
- *  file later. */
+ *  file later.
+ *
+ *  If ATTRIBUTES is given, it gets the vertex attributes : row i holds
+ *  those of the point of index i (as ptrs), one column per attribute. */
 void readNodeFile(const std::string &fname,
-		            std::vector<int> &pts, std::vector<Vector2dPtr> &ptrs);
+		            std::vector<int> &pts, std::vector<Vector2dPtr> &ptrs,
+		            ColMatrixXd *attributes=NULL);
+
+
+/** Reads a Triangle .poly file : its vertices (as readNodeFile; from the
+ *  .node file of the same name if the .poly lists none) and its segments,
+ *  as pairs of vertex indices. Holes and regional attributes are not read;
+ *  the vertex attributes are, into ATTRIBUTES if it is given. */
+void readPolyFile(const std::string &fname, std::vector<int> &pts,
+		std::vector<Vector2dPtr> &ptrs, std::vector<std::pair<int, int> > &segments,
+		ColMatrixXd *attributes=NULL);
 
 
 /** Writes an .ele and its corresponding .node file,
@@ -34,4 +50,92 @@ void readNodeFile(const std::string &fname,
  *  The name of the output file are {fname.ele, fname.node}. */
 void writeSubdivision(const std::string &fname, DelaunaySubdivision* sub);
 
+/** Writes the sites of SUB, with the new ones (e.g. Steiner points),
+ *  to the .node file fname. */
+void writeNodeFile(const std::string &fname, DelaunaySubdivision* sub);
+
+/** Writes the edges (2 end points each) to the .edge file fname :
+ *  <edge #> <vertex> <vertex>. */
+void writeEdgeFile(const std::string &fname, const std::vector<int> &edges);
+
+/** Writes each edge of GRAPH once (the smaller end first) to the .edge
+ *  file fname, as writeEdgeFile. */
+void writeGraph(const std::string &fname, const CSRGraph &graph);
+
+/** Serializes GRAPH into BUFFER (replacing its contents), as 32 bit
+ *  integers in the host byte order : n, the number of targets, the n+1
+ *  offsets, then the targets. */
+void packCSR(const CSRGraph &graph, std::vector<char> &buffer);
+
+/** Writes GRAPH to the binary file fname, in the layout of packCSR. */
+void writeCSRFile(const std::string &fname, const CSRGraph &graph);
+
+/** Serializes the triangulation which has the edge HANDLES.first into
+ *  BUFFER (replacing its contents), as 32 bit integers in the host byte
+ *  order : the number of quad-edges E, the indices of the two HANDLES,
+ *  the origin of each of the 2E directed edges, then the index of the
+ *  Onext of each. Directed edge 2q is quad-edge q, 2q+1 its Sym. Only the
+ *  site indices are stored : the reader must share the points. */
+void packTriangulation(std::pair<Edge::Ptr, Edge::Ptr> handles, std::vector<char> &buffer);
+
+/** Rebuilds a triangulation serialized by packTriangulation, from the
+ *  SIZE bytes at BUFFER. Returns its handles. */
+std::pair<Edge::Ptr, Edge::Ptr> unpackTriangulation(const char *buffer, size_t size);
+
+/** Writes the triangulation with the edge HANDLES.first to the binary
+ *  file fname, in the layout of packTriangulation. */
+void writeTriangulationFile(const std::string &fname, std::pair<Edge::Ptr, Edge::Ptr> handles);
+
+/** Reads a triangulation written by writeTriangulationFile. */
+std::pair<Edge::Ptr, Edge::Ptr> readTriangulationFile(const std::string &fname);
+
+/** Writes the boundary of an alpha shape (AlphaComplex::boundary) to the
+ *  .edge file fname : <edge #> <vertex> <vertex> <marker>, with marker 1
+ *  for the first REGULAR edges (the shape on their left), 0 for the
+ *  singular ones. */
+void writeAlphaShape(const std::string &fname, const std::vector<int> &edges, int regular);
+
+/** Writes the answers of DelaunaySubdivision::locateAll to fname.
+ *  Each line is : <query #> <vertex> <vertex> <vertex>, the ccw triangle
+ *  containing the query, or -1 -1 -1 if it is outside the convex hull. */
+void writeLocations(const std::string &fname, const std::vector<int> &ids,
+		const std::vector<Edge::Ptr> &result, DelaunaySubdivision* sub);
+
+/** Writes the attributes interpolated at the queries IDS (VALUES, as
+ *  Interpolator::interpolate) to fname. The first line is
+ *  <# of queries> <# of attributes>, then each line is :
+ *  <query #> <attributes>, nan outside the convex hull. */
+void writeInterpolation(const std::string &fname, const std::vector<int> &ids,
+		const RowMatrixXd &values);
+
+/** Serializes LINES into BUFFER (replacing its contents), in the host
+ *  byte order : the numbers of levels, of polylines and of points (32 bit
+ *  integers), the levels (64 bit floats), the level index of each polyline
+ *  and the offsets of their points (#polylines + 1, 32 bit integers), then
+ *  x, y of each point (64 bit floats). */
+void packContours(const Contours &lines, std::vector<char> &buffer);
+
+/** Writes LINES to the binary file fname, in the layout of packContours. */
+void writeContourFile(const std::string &fname, const Contours &lines);
+
+/** Writes the cells of GRID to the binary file fname, as 32 bit floats
+ *  in the host byte order, row by row from the top; NaN : no data. */
+void writeRaster(const std::string &fname, const RasterGrid &grid);
+
+/** Writes GRID as a 16 bit binary PGM image : the values are scaled
+ *  from 1 (lowest) to 65535 (highest), 0 is no data. A comment line
+ *  gives the box and the range of the values. */
+void writePGM(const std::string &fname, const RasterGrid &grid);
+
+/** Writes the convex hull HULL (vertex indices, ccw) to fname.
+ *  The first line is <# of hull vertices>, then each line is : <k> <vertex>. */
+void writeHull(const std::string &fname, const std::vector<int> &hull);
+
+/** Writes the Voronoi diagram of a delaunay triangulation, as
+ *  {fname.v.node, fname.v.edge, fname.v.cell}. The .v.edge file is in
+ *  Triangle's format : an infinite ray is written as <edge #> <v> -1 <dx> <dy>.
+ *  Each line of the .v.cell file is : <site> <k> x1 y1 ... xk yk, the ccw
+ *  cell of the site clipped to its bounding box enlarged by 10%. */
+void writeVoronoi(const std::string &fname, DelaunaySubdivision* sub);
+
 #endif //__IO_UTILS_H__
@@ -1,5 +1,18 @@
 #include <iostream>
+#include <stdlib.h>
+#include <sstream>
+#include <fstream>
 #include "qedge/DelaunaySubdivision.h"
+#include "qedge/io_utils.h"
+#include "qedge/DelaunayHierarchy.h"
+#include "qedge/AlphaComplex.h"
+#include "qedge/StripDelaunay.h"
+#include "qedge/SpanningTree.h"
+#include "qedge/ProximityGraph.h"
+#include "qedge/Interpolator.h"
+#include "qedge/Rasterizer.h"
+#include "qedge/ContourTracer.h"
+#include "utils/misc.h"
 
 using namespace std;
 
@@ -24,15 +37,297 @@ string welcome =
 		"*******************************************************\n\n";
 
 string usage =
-		"./delaunay -i input_file_name [-o output_file_name] [-A or V] [-T]\n"
-		"    -i input_file_name  : path to .node file\n"
+		"./delaunay -i input_file_name [-o output_file_name] [-A or V or P or M or I or D or S or --auto] [-w] [-j N] [--strips N] [-q query_file_name [-H] [--interp linear or sibson]] [--voronoi] [--hull or --hull-only] [--refine angle [--max-area A] [--max-steiner N]] [--alpha A[,A...]] [--emst] [--gabriel] [--rng] [--csr] [--raster W,H[,k]] [--contours L[,L...]] [--move node_file] [--edit script_file] [-T]\n"
+		"    -i input_file_name  : path to .node file, or to a .poly file : its segments\n"
+		"                          are then inserted as constrained edges.\n"
 		"    -o output_file_name : path to .ele file [optional].\n"
 		"                          If not specified the .ele file is\n"
 		"                          stored in the same directory as .node file.\n"
 		"    -A or -V            : switch between alternating [default] or vertical cuts.\n"
+		"    -P                  : seam-first cuts (DeWall) : the triangles across each cut\n"
+		"                          are built first, then the halves on parallel threads,\n"
+		"                          with no merge.\n"
+		"    -M                  : vertical cuts, with the strips and the merges of their\n"
+		"                          seams run in forked worker processes, which exchange\n"
+		"                          the triangulations through files next to the output.\n"
+		"    -j N                : number of threads used by -P, or of worker processes\n"
+		"                          used by -M [default : number of cores].\n"
+		"    -I                  : randomized incremental insertion (BRIO order).\n"
+		"    -D                  : Dwyer's cell bucketing : fastest on uniform points.\n"
+		"    -S                  : radial sweep-hull (s-hull) with a final flip pass.\n"
+		"    --auto              : probe the input points and pick one of the above.\n"
+		"                          The measurements and the choice are printed.\n"
+		"    -w                  : regular (weighted Delaunay) triangulation, weighted\n"
+		"                          by the first vertex attribute, by incremental insertion.\n"
+		"                          Sites which are not vertices are counted with -T.\n"
+		"    --strips N          : out-of-core : sort the points into vertical strips of\n"
+		"                          about N points on disk, and triangulate them left to\n"
+		"                          right, writing the final triangles as they come.\n"
+		"                          Only the .ele file is written; the other options\n"
+		"                          are ignored.\n"
+		"    -q query_file_name  : .node file of points to locate in the triangulation.\n"
+		"                          The triangle of each one is written to a .loc file\n"
+		"                          next to the .ele file (-1 -1 -1 : outside the hull).\n"
+		"    -H                  : locate the queries one by one, in file order, through\n"
+		"                          a Delaunay hierarchy, instead of as a sorted batch.\n"
+		"                          With --edit, also insert and remove the sites\n"
+		"                          through a Delaunay hierarchy.\n"
+		"    --interp linear     : with -q, also interpolate the vertex attributes of the\n"
+		"    --interp sibson       input at the queries, linearly or by natural neighbours,\n"
+		"                          into a .interp file (nan : outside the hull).\n"
+		"    --voronoi           : also write the Voronoi diagram, next to the .ele file,\n"
+		"                          as .v.node, .v.edge and .v.cell (clipped cells) files.\n"
+		"    --hull              : also write the ccw convex hull vertices to a .hull file.\n"
+		"    --hull-only         : only compute the convex hull (monotone chain), no .ele.\n"
+		"    --refine angle      : add Steiner points (Ruppert) till no angle is below\n"
+		"                          angle degrees. The output is written, with the new\n"
+		"                          sites, as .1.node and .1.ele files.\n"
+		"    --max-area A        : with --refine, also split the triangles above area A.\n"
+		"    --max-steiner N     : with --refine, add at most N Steiner points.\n"
+		"    --alpha A[,A...]    : write the boundary of the alpha shape for each\n"
+		"                          alpha (a squared radius) to .a1.edge, .a2.edge...\n"
+		"    --emst              : write the Euclidean minimum spanning tree to\n"
+		"                          a .emst.edge file.\n"
+		"    --gabriel           : write the Gabriel graph to a .gg.edge file.\n"
+		"    --rng               : write the relative neighbourhood graph to\n"
+		"                          a .rng.edge file.\n"
+		"    --csr               : write the Delaunay graph (ccw neighbours of each\n"
+		"                          site) to a binary .csr file : see packCSR.\n"
+		"    --raster W,H[,k]    : rasterize the linear interpolation of the vertex\n"
+		"                          attribute k [default : 0] onto W x H cells over the\n"
+		"                          bounding box of the sites, as a .raw file (floats,\n"
+		"                          top row first) and a 16 bit .pgm image.\n"
+		"    --contours L[,L...] : write the contour lines of the first vertex attribute\n"
+		"                          at the levels L to a binary .iso file : see\n"
+		"                          packContours.\n"
+		"    --move node_file    : move the sites to their positions (by index) in\n"
+		"                          node_file, repair the triangulation by flips, and\n"
+		"                          write it as .m.node and .m.ele files.\n"
+		"    --edit script_file  : edit the triangulation site by site, in the order of\n"
+		"                          the lines of script_file :\n"
+		"                              i x y : insert the site (x, y)\n"
+		"                              r id  : remove the site id\n"
+		"                          and write it as .e.node and .e.ele files. The new\n"
+		"                          sites are numbered after the input ones.\n"
 		"    -T                  : print the time taken for the algorithm to run.\n"
 		"                          File I/O time is excluded.\n\n";
 
+/** Locates the points of the .node file QUERIES in the triangulation,
+ *  and writes their triangles to the .loc file next to the .ele file. */
+void locateQueries(DelaunaySubdivision &subD, const string &queries, bool hierarchy,
+		CutsType cuts, bool time) {
+	vector<int> ids;
+	vector<Vector2dPtr> ptrs;
+	readNodeFile(queries, ids, ptrs);
+	vector<Edge::Ptr> result;
+	if (!hierarchy) {
+		subD.locateAll(ids, ptrs, result, time);
+	} else {
+		// one query at a time, in the order of the file.
+		double tim = wallTime();
+		DelaunayHierarchy H(&subD, cuts);
+		if (time) cout <<">>> "<<wallTime()-tim<<" seconds to build "<<H.numLevels()<<" hierarchy levels.\n";
+
+		tim = wallTime();
+		result.resize(ids.size());
+		for (int i = 0; i < ids.size(); i += 1)
+			result[i] = H.locate(*ptrs[ids[i]]);
+		tim = wallTime() - tim;
+		if (time) cout <<">>> located "<<ids.size()<<" points in "<<tim<<" seconds ("
+				<<ids.size()/tim<<" queries/s, hierarchy).\n";
+	}
+	writeLocations(subD.out_prefix+".loc", ids, result, &subD);
+}
+
+/** Interpolates the vertex attributes at the points of the .node file
+ *  QUERIES, and writes them to the .interp file next to the .ele file. */
+void interpolateQueries(DelaunaySubdivision &subD, const string &queries, bool sibson, bool time) {
+	vector<int> ids;
+	vector<Vector2dPtr> ptrs;
+	readNodeFile(queries, ids, ptrs);
+	RowMatrixXd values;
+	Interpolator(&subD, sibson).interpolate(ids, ptrs, values, time);
+	if (values.cols()) writeInterpolation(subD.out_prefix+".interp", ids, values);
+}
+
+/** Writes the convex hull to the .hull file next to the .ele file :
+ *  from the triangulation, or, with ONLY, from the points alone. */
+void convexHull(DelaunaySubdivision &subD, bool only, bool time) {
+	vector<int> hull;
+	double tim = wallTime();
+	if (only) subD.monotoneChainHull(hull);
+	else      subD.convexHull(hull);
+	tim = wallTime() - tim;
+	if (time) cout <<">>> "<<tim<<" seconds to find the "<<hull.size()<<" hull vertices"
+			<<(only? " (monotone chain).\n" : " (outer face walk).\n");
+	writeHull(subD.out_prefix+".hull", hull);
+}
+
+/** Writes the boundary of the alpha shape for each of ALPHAS to the
+ *  .a<k>.edge files next to the .ele file. */
+void alphaShapes(DelaunaySubdivision &subD, const vector<double> &alphas, bool time) {
+	AlphaComplex A(&subD, time);
+	for (int k = 0; k < alphas.size(); k += 1) {
+		vector<int> edges;
+		double tim = wallTime();
+		const int regular = A.boundary(alphas[k], edges);
+		tim = wallTime() - tim;
+		if (time) cout <<">>> alpha "<<alphas[k]<<" : "<<regular<<" regular and "<<edges.size()/2-regular
+				<<" singular boundary edges, "<<A.numTriangles(alphas[k])<<" triangles, in "<<tim<<" seconds.\n";
+		stringstream fname;
+		fname << subD.out_prefix<<".a"<<k+1<<".edge";
+		writeAlphaShape(fname.str(), edges, regular);
+	}
+}
+
+/** Writes the EMST to the .emst.edge file next to the .ele file. */
+void spanningTree(DelaunaySubdivision &subD, bool time) {
+	SpanningTree T(&subD, time);
+	writeEdgeFile(subD.out_prefix+".emst.edge", T.edges);
+}
+
+/** Writes the Delaunay graph to the binary .csr file next to the .ele file. */
+void delaunayGraph(DelaunaySubdivision &subD, bool time) {
+	CSRGraph graph(&subD, time);
+	writeCSRFile(subD.out_prefix+".csr", graph);
+}
+
+/** Rasterizes the attribute CHANNEL onto a W x H grid over the bounding box
+ *  of the sites, and writes the .raw and .pgm files next to the .ele file. */
+void rasterize(DelaunaySubdivision &subD, int W, int H, int channel, bool time) {
+	RasterGrid grid;
+	grid.width = W; grid.height = H;
+	bool first = true;
+	for (int i = 0; i < subD.point_ptrs.size(); i += 1) {
+		if (!subD.point_ptrs[i]) continue;
+		const Eigen::Vector2d &p = *subD.point_ptrs[i];
+		grid.lo = first? p : grid.lo.cwiseMin(p);
+		grid.hi = first? p : grid.hi.cwiseMax(p);
+		first = false;
+	}
+	Rasterizer(&subD, channel).rasterize(grid, time);
+	if (grid.z.empty()) return;
+	writeRaster(subD.out_prefix+".raw", grid);
+	writePGM(subD.out_prefix+".pgm", grid);
+}
+
+/** Writes the contour lines of the first attribute at LEVELS to the binary
+ *  .iso file next to the .ele file. */
+void contourLines(DelaunaySubdivision &subD, const vector<double> &levels, bool time) {
+	Contours lines;
+	ContourTracer(&subD, 0).contours(levels, lines, time);
+	if (subD.attributes.cols()) writeContourFile(subD.out_prefix+".iso", lines);
+}
+
+/** Writes the Gabriel graph to the .gg.edge file, or with RNG the relative
+ *  neighbourhood graph to the .rng.edge file, next to the .ele file. */
+void proximityGraph(DelaunaySubdivision &subD, bool rng, bool time) {
+	ProximityGraph G(&subD, rng, time);
+	writeGraph(subD.out_prefix+(rng? ".rng.edge" : ".gg.edge"), G.graph);
+}
+
+/** Moves the sites to their positions in the .node file MOVES (the sites
+ *  it does not list stay), repairs the triangulation, and writes it as the
+ *  .m.node and .m.ele files next to the .ele file. */
+void moveSites(DelaunaySubdivision &subD, const string &moves, bool time) {
+	ifstream infile(moves.c_str());
+	if (!infile.is_open()) {
+		cout << "Unable to open file : " << moves << endl;
+		exit(-1);
+	}
+	RowMatrixXd positions(subD.point_ptrs.size(), 2);
+	for (int v = 0; v < subD.point_ptrs.size(); v += 1)
+		if (subD.point_ptrs[v]) positions.row(v) = subD.point_ptrs[v]->transpose();
+
+	// read line by line : the indices are those of the input, not 1..N.
+	bool first = true;
+	string line;
+	while (getline(infile, line)) {
+		stringstream ss(line);
+		string head;
+		if (!(ss >> head) || head[0] == '#') continue;
+		if (first) { // the header : <# of vertices> <dimension> ...
+			first = false;
+			continue;
+		}
+		const int id = atoi(head.c_str());
+		double x, y;
+		if (!(ss >> x >> y)) {
+			cout << ">>> Bad line in "<<moves<<" : "<<line<<". Skipping.\n";
+			continue;
+		}
+		if (id < 0 || id >= subD.point_ptrs.size() || !subD.point_ptrs[id]) {
+			cout << ">>> No site "<<id<<" to move. Skipping.\n";
+			continue;
+		}
+		positions(id,0) = x;
+		positions(id,1) = y;
+	}
+	subD.updateCoordinates(positions, 0.01, time);
+	subD.out_prefix += ".m";
+	writeNodeFile(subD.out_prefix+".node", &subD);
+	subD.writeToFile();
+}
+
+/** Edits the triangulation by the lines of the script file EDITS, in
+ *  order : "i x y" inserts the site (x, y), "r id" removes the site id,
+ *  through a Delaunay hierarchy if HIERARCHY. Writes the result as the
+ *  .e.node and .e.ele files next to the .ele file.*/
+void editSites(DelaunaySubdivision &subD, const string &edits, bool hierarchy,
+		CutsType cuts, bool time) {
+	ifstream infile(edits.c_str());
+	if (!infile.is_open()) {
+		cout << "Unable to open file : " << edits << endl;
+		exit(-1);
+	}
+	vector<char> ops;
+	vector<double> args; // x y of an insert, or id and 0 for a removal
+	string line;
+	while (getline(infile, line)) {
+		stringstream ss(line);
+		string op;
+		if (!(ss >> op) || op[0] == '#') continue;
+		double x, y = 0;
+		int id;
+		if (op == "r" && (ss >> id)) {
+			x = id;
+		} else if (op != "i" || !(ss >> x >> y)) {
+			cout << ">>> Bad line in "<<edits<<" : "<<line<<". Skipping.\n";
+			continue;
+		}
+		ops.push_back(op[0]);
+		args.push_back(x);
+		args.push_back(y);
+	}
+
+	DelaunayHierarchy::Ptr H;
+	double tim = wallTime();
+	if (hierarchy) {
+		H.reset(new DelaunayHierarchy(&subD, cuts));
+		if (time) cout <<">>> "<<wallTime()-tim<<" seconds to build "<<H->numLevels()<<" hierarchy levels.\n";
+	}
+
+	int inserted = 0, removed = 0;
+	tim = wallTime();
+	for (int k = 0; k < ops.size(); k += 1) {
+		if (ops[k] == 'i') {
+			if (H) H->insertSite(args[2*k], args[2*k+1]);
+			else   subD.insertSite(args[2*k], args[2*k+1]);
+			inserted += 1;
+		} else if (H? H->removeSite(int(args[2*k])) : subD.removeSite(int(args[2*k]))) {
+			removed += 1;
+		} else {
+			cout << ">>> No site "<<int(args[2*k])<<" to remove. Skipping.\n";
+		}
+	}
+	tim = wallTime() - tim;
+	if (time) cout <<">>> inserted "<<inserted<<" and removed "<<removed<<" sites in "<<tim<<" seconds"
+			<<(H? " (hierarchy).\n" : ".\n");
+	subD.out_prefix += ".e";
+	writeNodeFile(subD.out_prefix+".node", &subD);
+	subD.writeToFile();
+}
+
 void printUsageAndExit() {
 	cout << usage;
 	exit(0);
@@ -43,10 +338,26 @@ int main(int argc, char** argv) {
 		cout << welcome;
 		exit(0);
 	}
-	string input, output;
+	string input, output, queries, moves, edits;
 
-	bool vertical       = false;
+	CutsType cuts       = ALTERNATE_CUTS;
+	int  num_threads    = 0;
+	long long strips    = 0; // out-of-core if positive
 	bool time_algorithm = false;
+	bool hierarchy      = false;
+	bool voronoi        = false;
+	bool emst           = false;
+	bool gabriel        = false;
+	bool csr            = false;
+	bool rng            = false;
+	bool weighted       = false;
+	int  interp         = 0; // 1 : linear, 2 : natural neighbours
+	int  hull           = 0; // 1 : with the triangulation, 2 : only the hull
+	double min_angle    = -1; // refine if positive
+	double max_area     = -1;
+	int  max_steiner    = -1;
+	vector<double> alphas, levels;
+	int  raster[3]      = {0, 0, 0}; // width, height, attribute
 	for ( int i = 1; i < argc; ++i ) {
 		std::string arg( argv[i] );
 		if ( arg == "--help" || arg == "-h" ) {
@@ -59,11 +370,98 @@ int main(int argc, char** argv) {
 		} else if ( arg == "-o" ) {
 			output = argv[++i];
 		} else if ( arg == "-V" ) {
-			vertical = true;
+			cuts = VERTICAL_CUTS;
+		} else if ( arg == "--auto" ) {
+			cuts = AUTO_CUTS;
+		} else if ( arg == "-S" ) {
+			cuts = SWEEP_HULL;
+		} else if ( arg == "-D" ) {
+			cuts = DWYER_CUTS;
+		} else if ( arg == "-I" ) {
+			cuts = INCREMENTAL;
+		} else if ( arg == "-P" ) {
+			cuts = PARALLEL_CUTS;
+		} else if ( arg == "-M" ) {
+			cuts = PROCESS_CUTS;
+		} else if ( arg == "-w" ) {
+			weighted = true;
+		} else if ( arg == "-j" ) {
+			if ( i == argc-1 ) {
+				printUsageAndExit();
+			}
+			num_threads = atoi(argv[++i]);
+		} else if ( arg == "--strips" ) {
+			if ( i == argc-1 ) {
+				printUsageAndExit();
+			}
+			strips = atoll(argv[++i]);
+		} else if ( arg == "-q" ) {
+			if ( i == argc-1 ) {
+				printUsageAndExit();
+			}
+			queries = argv[++i];
+		} else if ( arg == "--move" ) {
+			if ( i == argc-1 ) {
+				printUsageAndExit();
+			}
+			moves = argv[++i];
+		} else if ( arg == "--edit" ) {
+			if ( i == argc-1 ) {
+				printUsageAndExit();
+			}
+			edits = argv[++i];
+		} else if ( arg == "-H" ) {
+			hierarchy = true;
+		} else if ( arg == "--interp" ) {
+			if ( i == argc-1 ) {
+				printUsageAndExit();
+			}
+			const string kind(argv[++i]);
+			if      (kind == "linear") interp = 1;
+			else if (kind == "sibson") interp = 2;
+			else printUsageAndExit();
+		} else if ( arg == "--refine" || arg == "--max-area" || arg == "--max-steiner" ) {
+			if ( i == argc-1 ) {
+				printUsageAndExit();
+			}
+			if      (arg == "--refine")   min_angle   = atof(argv[++i]);
+			else if (arg == "--max-area") max_area    = atof(argv[++i]);
+			else                          max_steiner = atoi(argv[++i]);
+		} else if ( arg == "--hull" ) {
+			hull = 1;
+		} else if ( arg == "--hull-only" ) {
+			hull = 2;
+		} else if ( arg == "--alpha" || arg == "--contours" ) {
+			if ( i == argc-1 ) {
+				printUsageAndExit();
+			}
+			vector<double> &values = (arg == "--alpha")? alphas : levels;
+			stringstream list(argv[++i]);
+			string a;
+			while (getline(list, a, ','))
+				values.push_back(atof(a.c_str()));
+		} else if ( arg == "--raster" ) {
+			if ( i == argc-1 ) {
+				printUsageAndExit();
+			}
+			stringstream list(argv[++i]);
+			string a;
+			for (int k = 0; k < 3 && getline(list, a, ','); k += 1)
+				raster[k] = atoi(a.c_str());
+		} else if ( arg == "--csr" ) {
+			csr = true;
+		} else if ( arg == "--gabriel" ) {
+			gabriel = true;
+		} else if ( arg == "--rng" ) {
+			rng = true;
+		} else if ( arg == "--emst" ) {
+			emst = true;
+		} else if ( arg == "--voronoi" ) {
+			voronoi = true;
 		} else if (arg == "-T") {
 			time_algorithm = true;
 		} else if (arg == "-A") {
-			continue;
+			cuts = ALTERNATE_CUTS;
 		} else {
 			cout << "Unknown option: '" << arg << "'\n";
 			printUsageAndExit();
@@ -73,17 +471,47 @@ int main(int argc, char** argv) {
 	if(!input.length())
 		printUsageAndExit();
 
-	if (!output.length()) {
-		cout << "reading input.."<<endl;
-		DelaunaySubdivision subD(input);
-		cout << "input done"<<endl;
-		subD.computeDelaunay(((vertical)? VERTICAL_CUTS : ALTERNATE_CUTS), time_algorithm);
-		subD.writeToFile();
-	} else {
-		cout << "reading input.."<<endl;
-		DelaunaySubdivision subD(input, output);
-		cout << "input done"<<endl;
-		subD.computeDelaunay(((vertical)? VERTICAL_CUTS : ALTERNATE_CUTS), time_algorithm);
-		subD.writeToFile();
+	if (strips > 0) {
+		const string ext = (input.length() < 5)? input : input.substr(input.length()-5, 5);
+		if (ext != ".node") {
+			cout << "Out-of-core triangulation : expecting a .node file. Exiting.\n";
+			exit(-1);
+		}
+		StripDelaunay strip(input, output.length()? output : input.substr(0, input.length()-5), strips);
+		strip.run(time_algorithm);
+		return 0;
+	}
+
+	cout << "reading input.."<<endl;
+	DelaunaySubdivision::Ptr sub = output.length()? DelaunaySubdivision::Ptr(new DelaunaySubdivision(input, output))
+	                                               : DelaunaySubdivision::Ptr(new DelaunaySubdivision(input));
+	DelaunaySubdivision &subD = *sub;
+	cout << "input done"<<endl;
+	if (num_threads > 0) subD.num_threads = num_threads;
+	if (hull == 2) {
+		convexHull(subD, true, time_algorithm);
+		return 0;
+	}
+	if (weighted) subD.computeRegular(0, time_algorithm);
+	else          subD.computeDelaunay(cuts, time_algorithm);
+	if (subD.segments.size() && !weighted) subD.insertSegments(time_algorithm);
+	if (min_angle > 0 || max_area > 0) {
+		subD.refine(std::max(min_angle, 0.0), max_area, max_steiner, time_algorithm);
+		subD.out_prefix += ".1";
+		writeNodeFile(subD.out_prefix+".node", &subD);
 	}
+	subD.writeToFile();
+	if (hull == 1) convexHull(subD, false, time_algorithm);
+	if (voronoi) writeVoronoi(subD.out_prefix, &subD);
+	if (alphas.size()) alphaShapes(subD, alphas, time_algorithm);
+	if (emst) spanningTree(subD, time_algorithm);
+	if (gabriel) proximityGraph(subD, false, time_algorithm);
+	if (rng) proximityGraph(subD, true, time_algorithm);
+	if (csr) delaunayGraph(subD, time_algorithm);
+	if (raster[0] > 0) rasterize(subD, raster[0], raster[1], raster[2], time_algorithm);
+	if (levels.size()) contourLines(subD, levels, time_algorithm);
+	if (queries.length()) locateQueries(subD, queries, hierarchy, cuts, time_algorithm);
+	if (queries.length() && interp) interpolateQueries(subD, queries, interp == 2, time_algorithm);
+	if (moves.length()) moveSites(subD, moves, time_algorithm);
+	if (edits.length()) editSites(subD, edits, hierarchy, cuts, time_algorithm);
 }
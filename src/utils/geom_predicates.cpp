@@ -16,6 +16,10 @@ void inline initExact() {
 	}
 }
 
+void initPredicates() {
+	initExact();
+}
+
 double orient2d (Vector2d pa, Vector2d pb, Vector2d pc) {
 	initExact();
 	return (double) orient2d(pa.data(), pb.data(), pc.data());
@@ -60,3 +64,220 @@ bool cw(Vector2d pa, Vector2d pb, Vector2d pc) {
 bool cw(Vector2f pa, Vector2f pb, Vector2f pc) {
 	return (bool) (orient2d(pa, pb, pc) < 0.0);
 }
+
+/** Exact -(a-c).(b-c), as the sum of the products of the coordinates. */
+static REAL indiametralexact(REAL *pa, REAL *pb, REAL *pc) {
+	INEXACT REAL ab1, ac1, bc1, cc1;
+	REAL ab0, ac0, bc0, cc0;
+	REAL terms[4][4];
+	INEXACT REAL terms3;
+	REAL u[8], v[8], w[16];
+	int ulength, vlength, wlength;
+
+	INEXACT REAL bvirt;
+	REAL avirt, bround, around;
+	INEXACT REAL c;
+	INEXACT REAL abig;
+	REAL ahi, alo, bhi, blo;
+	REAL err1, err2, err3;
+	INEXACT REAL _i, _j;
+	REAL _0;
+
+	// per axis : (a c + b c) - (a b + c c)
+	for (int k = 0; k < 2; k += 1) {
+		Two_Product(pa[k], pc[k], ac1, ac0);
+		Two_Product(pb[k], pc[k], bc1, bc0);
+		Two_Two_Sum(ac1, ac0, bc1, bc0, terms3, terms[2*k][2], terms[2*k][1], terms[2*k][0]);
+		terms[2*k][3] = terms3;
+		Two_Product(pa[k], pb[k], ab1, ab0);
+		Two_Product(pc[k], pc[k], cc1, cc0);
+		Two_Two_Sum(ab1, ab0, cc1, cc0, terms3, terms[2*k+1][2], terms[2*k+1][1], terms[2*k+1][0]);
+		terms[2*k+1][3] = terms3;
+		for (int i = 0; i < 4; i += 1) terms[2*k+1][i] = -terms[2*k+1][i];
+	}
+	ulength = fast_expansion_sum_zeroelim(4, terms[0], 4, terms[1], u);
+	vlength = fast_expansion_sum_zeroelim(4, terms[2], 4, terms[3], v);
+	wlength = fast_expansion_sum_zeroelim(ulength, u, vlength, v, w);
+	return w[wlength - 1];
+}
+
+double indiametral (Vector2d pa, Vector2d pb, Vector2d pc) {
+	initExact();
+	const double dl = (pa[0] - pc[0]) * (pb[0] - pc[0]);
+	const double dr = (pa[1] - pc[1]) * (pb[1] - pc[1]);
+	const double det = -(dl + dr);
+	// same error bound as orient2d : a sum of two products of differences.
+	const double errbound = ccwerrboundA * (Absolute(dl) + Absolute(dr));
+	if (det > errbound || -det > errbound) return det;
+	return indiametralexact(pa.data(), pb.data(), pc.data());
+}
+
+/** Exact |b-a|^2 - |c-a|^2 = (b b + 2 a c) - (c c + 2 a b), per axis. */
+static REAL closerexact(REAL *pa, REAL *pb, REAL *pc) {
+	INEXACT REAL bb1, cc1, ab1, ac1;
+	REAL bb0, cc0, ab0, ac0;
+	REAL terms[4][4];
+	INEXACT REAL terms3;
+	REAL u[8], v[8], w[16];
+	int ulength, vlength, wlength;
+
+	INEXACT REAL bvirt;
+	REAL avirt, bround, around;
+	INEXACT REAL c;
+	INEXACT REAL abig;
+	REAL ahi, alo, bhi, blo;
+	REAL err1, err2, err3;
+	INEXACT REAL _i, _j;
+	REAL _0;
+
+	for (int k = 0; k < 2; k += 1) {
+		const REAL a2 = 2.0 * pa[k]; // exact
+		Two_Product(pb[k], pb[k], bb1, bb0);
+		Two_Product(a2, pc[k], ac1, ac0);
+		Two_Two_Sum(bb1, bb0, ac1, ac0, terms3, terms[2*k][2], terms[2*k][1], terms[2*k][0]);
+		terms[2*k][3] = terms3;
+		Two_Product(pc[k], pc[k], cc1, cc0);
+		Two_Product(a2, pb[k], ab1, ab0);
+		Two_Two_Sum(cc1, cc0, ab1, ab0, terms3, terms[2*k+1][2], terms[2*k+1][1], terms[2*k+1][0]);
+		terms[2*k+1][3] = terms3;
+		for (int i = 0; i < 4; i += 1) terms[2*k+1][i] = -terms[2*k+1][i];
+	}
+	ulength = fast_expansion_sum_zeroelim(4, terms[0], 4, terms[1], u);
+	vlength = fast_expansion_sum_zeroelim(4, terms[2], 4, terms[3], v);
+	wlength = fast_expansion_sum_zeroelim(ulength, u, vlength, v, w);
+	return w[wlength - 1];
+}
+
+double closer (Vector2d pa, Vector2d pb, Vector2d pc) {
+	initExact();
+	// |b-a|^2 - |c-a|^2 = (b-c).(b+c-2a)
+	const double dl = (pb[0] - pc[0]) * (pb[0] + pc[0] - 2.0*pa[0]);
+	const double dr = (pb[1] - pc[1]) * (pb[1] + pc[1] - 2.0*pa[1]);
+	const double det = dl + dr;
+	// a few roundings in each product : a generous bound, the exact
+	// expansion settles the close calls.
+	const double permanent = Absolute(pb[0] - pc[0]) * (Absolute(pb[0]) + Absolute(pc[0]) + 2.0*Absolute(pa[0]))
+	                       + Absolute(pb[1] - pc[1]) * (Absolute(pb[1]) + Absolute(pc[1]) + 2.0*Absolute(pa[1]));
+	const double errbound = 8.0 * epsilon * permanent;
+	if (det > errbound || -det > errbound) return det;
+	return closerexact(pa.data(), pb.data(), pc.data());
+}
+
+
+/** Exact power test : incircleexact's determinant with the lifts
+ *  x^2 + y^2 - w. The determinant is linear in the lift column, so the
+ *  weights add the 3x3 minors scaled by -wa, +wb, -wc, +wd. */
+static REAL powertestexact(REAL *pa, REAL *pb, REAL *pc, REAL *pd,
+		REAL wa, REAL wb, REAL wc, REAL wd) {
+	INEXACT REAL p1, q1;
+	REAL p0, q0;
+	REAL ab[4], bc[4], cd[4], da[4], ac[4], bd[4];
+	REAL temp8[8];
+	int templen;
+	REAL abc[12], bcd[12], cda[12], dab[12];
+	int abclen, bcdlen, cdalen, dablen;
+	REAL det24x[24], det24y[24], det48x[48], det48y[48];
+	int xlen, ylen;
+	REAL lift[4][96], weight[4][24];
+	int liftlen[4], weightlen[4];
+	REAL sum192[2][192], lifts[384], weights[96], sum48[2][48];
+	int len192[2], liftslen, weightslen, len48[2];
+	REAL deter[480];
+	int deterlen;
+
+	INEXACT REAL bvirt;
+	REAL avirt, bround, around;
+	INEXACT REAL c;
+	INEXACT REAL abig;
+	REAL ahi, alo, bhi, blo;
+	REAL err1, err2, err3;
+	INEXACT REAL _i, _j;
+	REAL _0;
+
+	// the 2x2 minors x_i y_j - x_j y_i
+	REAL *rows[6][2] = {{pa, pb}, {pb, pc}, {pc, pd}, {pd, pa}, {pa, pc}, {pb, pd}};
+	REAL *minors[6]  = {ab, bc, cd, da, ac, bd};
+	for (int k = 0; k < 6; k += 1) {
+		Two_Product(rows[k][0][0], rows[k][1][1], p1, p0);
+		Two_Product(rows[k][1][0], rows[k][0][1], q1, q0);
+		Two_Two_Diff(p1, p0, q1, q0, minors[k][3], minors[k][2], minors[k][1], minors[k][0]);
+	}
+
+	// the 3x3 minors, as in incircleexact
+	templen = fast_expansion_sum_zeroelim(4, cd, 4, da, temp8);
+	cdalen = fast_expansion_sum_zeroelim(templen, temp8, 4, ac, cda);
+	templen = fast_expansion_sum_zeroelim(4, da, 4, ab, temp8);
+	dablen = fast_expansion_sum_zeroelim(templen, temp8, 4, bd, dab);
+	for (int i = 0; i < 4; i += 1) {
+		bd[i] = -bd[i];
+		ac[i] = -ac[i];
+	}
+	templen = fast_expansion_sum_zeroelim(4, ab, 4, bc, temp8);
+	abclen = fast_expansion_sum_zeroelim(templen, temp8, 4, ac, abc);
+	templen = fast_expansion_sum_zeroelim(4, bc, 4, cd, temp8);
+	bcdlen = fast_expansion_sum_zeroelim(templen, temp8, 4, bd, bcd);
+
+	// each minor times the lift of the point it leaves out, with the sign
+	// of its cofactor.
+	REAL *pts[4]    = {pa, pb, pc, pd};
+	REAL ws[4]      = {wa, wb, wc, wd};
+	REAL *minor3[4] = {bcd, cda, dab, abc};
+	int  len3[4]    = {bcdlen, cdalen, dablen, abclen};
+	for (int k = 0; k < 4; k += 1) {
+		const REAL s = (k & 1)? -1.0 : 1.0;
+		xlen = scale_expansion_zeroelim(len3[k], minor3[k], pts[k][0], det24x);
+		xlen = scale_expansion_zeroelim(xlen, det24x, s*pts[k][0], det48x);
+		ylen = scale_expansion_zeroelim(len3[k], minor3[k], pts[k][1], det24y);
+		ylen = scale_expansion_zeroelim(ylen, det24y, s*pts[k][1], det48y);
+		liftlen[k] = fast_expansion_sum_zeroelim(xlen, det48x, ylen, det48y, lift[k]);
+		weightlen[k] = scale_expansion_zeroelim(len3[k], minor3[k], -s*ws[k], weight[k]);
+	}
+
+	len192[0] = fast_expansion_sum_zeroelim(liftlen[0], lift[0], liftlen[1], lift[1], sum192[0]);
+	len192[1] = fast_expansion_sum_zeroelim(liftlen[2], lift[2], liftlen[3], lift[3], sum192[1]);
+	liftslen = fast_expansion_sum_zeroelim(len192[0], sum192[0], len192[1], sum192[1], lifts);
+	len48[0] = fast_expansion_sum_zeroelim(weightlen[0], weight[0], weightlen[1], weight[1], sum48[0]);
+	len48[1] = fast_expansion_sum_zeroelim(weightlen[2], weight[2], weightlen[3], weight[3], sum48[1]);
+	weightslen = fast_expansion_sum_zeroelim(len48[0], sum48[0], len48[1], sum48[1], weights);
+	deterlen = fast_expansion_sum_zeroelim(liftslen, lifts, weightslen, weights, deter);
+	return deter[deterlen - 1];
+}
+
+double powertest (Vector2d pa, Vector2d pb, Vector2d pc, Vector2d pd,
+		double wa, double wb, double wc, double wd) {
+	initExact();
+	const double adx = pa[0] - pd[0], ady = pa[1] - pd[1];
+	const double bdx = pb[0] - pd[0], bdy = pb[1] - pd[1];
+	const double cdx = pc[0] - pd[0], cdy = pc[1] - pd[1];
+	const double awd = wa - wd, bwd = wb - wd, cwd = wc - wd;
+
+	const double bdxcdy = bdx * cdy, cdxbdy = cdx * bdy;
+	const double cdxady = cdx * ady, adxcdy = adx * cdy;
+	const double adxbdy = adx * bdy, bdxady = bdx * ady;
+	const double alift = adx * adx + ady * ady, blift = bdx * bdx + bdy * bdy;
+	const double clift = cdx * cdx + cdy * cdy;
+	const double det = (alift - awd) * (bdxcdy - cdxbdy)
+	                 + (blift - bwd) * (cdxady - adxcdy)
+	                 + (clift - cwd) * (adxbdy - bdxady);
+
+	// incircle's bound, with the weight differences in the lifts; doubled
+	// for their roundings. The exact expansion settles the close calls.
+	const double permanent = (Absolute(bdxcdy) + Absolute(cdxbdy)) * (alift + Absolute(awd))
+	                       + (Absolute(cdxady) + Absolute(adxcdy)) * (blift + Absolute(bwd))
+	                       + (Absolute(adxbdy) + Absolute(bdxady)) * (clift + Absolute(cwd));
+	const double errbound = 2.0 * iccerrboundA * permanent;
+	if (det > errbound || -det > errbound) return det;
+	return powertestexact(pa.data(), pb.data(), pc.data(), pd.data(), wa, wb, wc, wd);
+}
+
+
+/** Circumcenter of the triangle pa, pb, pc (floating-point construction).
+ *  Not robust : the triangle must not be degenerate. */
+Vector2d circumcenter(const Vector2d &pa, const Vector2d &pb, const Vector2d &pc) {
+	const Vector2d b = pb - pa;
+	const Vector2d c = pc - pa;
+	const double d  = 2.0 * (b.x()*c.y() - b.y()*c.x());
+	const double bb = b.squaredNorm();
+	const double cc = c.squaredNorm();
+	return pa + Vector2d((c.y()*bb - b.y()*cc) / d, (b.x()*cc - c.x()*bb) / d);
+}
@@ -3,6 +3,10 @@
 #pragma once
 #include <Eigen/Dense>
 
+/** Initializes the constants used by Shewchuk's predicates.
+ *  The predicates do this lazily; call this before using them from
+ *  multiple threads. */
+void initPredicates();
 
 double orient2d (Eigen::Vector2d pa, Eigen::Vector2d pb, Eigen::Vector2d pc);
 double orient2d (Eigen::Vector2f pa, Eigen::Vector2f pb, Eigen::Vector2f pc);
@@ -18,3 +22,26 @@ bool ccw(Eigen::Vector2f pa, Eigen::Vector2f pb, Eigen::Vector2f pc);
 bool cw(Eigen::Vector2d pa, Eigen::Vector2d pb, Eigen::Vector2d pc) ;
 bool cw(Eigen::Vector2f pa, Eigen::Vector2f pb, Eigen::Vector2f pc);
 
+
+/** Positive if pc lies inside the circle with diameter pa-pb, negative if
+ *  outside, zero if on it : the sign of -(pa-pc).(pb-pc), computed exactly
+ *  (adaptively, like orient2d). */
+double indiametral (Eigen::Vector2d pa, Eigen::Vector2d pb, Eigen::Vector2d pc);
+
+/** Positive if pc is closer to pa than pb is, negative if farther, zero if
+ *  as far : the sign of |pb-pa|^2 - |pc-pa|^2, computed exactly. */
+double closer (Eigen::Vector2d pa, Eigen::Vector2d pb, Eigen::Vector2d pc);
+
+
+/** Power test of the weighted points (pa, wa) .. (pd, wd) : positive if
+ *  pd, lifted to x^2 + y^2 - wd, lies below the plane through the lifted
+ *  pa, pb, pc (taken ccw), i.e. pd is closer, in power distance, to their
+ *  orthogonal circle than its radius; negative if above, zero if on it.
+ *  With all the weights zero, the sign of incircle. Computed exactly
+ *  (adaptively, like incircle). */
+double powertest (Eigen::Vector2d pa, Eigen::Vector2d pb, Eigen::Vector2d pc, Eigen::Vector2d pd,
+		double wa, double wb, double wc, double wd);
+
+/** Circumcenter of the triangle pa, pb, pc (floating-point construction).
+ *  Not robust : the triangle must not be degenerate. */
+Eigen::Vector2d circumcenter(const Eigen::Vector2d &pa, const Eigen::Vector2d &pb, const Eigen::Vector2d &pc);
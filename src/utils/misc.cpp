@@ -1,5 +1,7 @@
 
 #include "misc.h"
+#include <sys/time.h>
+#include <stddef.h>
 
 /** Gives the positive modulus. */
 template<typename V>
@@ -16,3 +18,12 @@ bool in_range(const int i, const int s, const int e, const int N) {
 	else if (s > e) {return ((s<=i && i< N)||(0<=i && i<= e));}
 }
 
+
+
+/** Wall-clock time in seconds.
+ *  Unlike clock(), this does not add up the time of concurrent threads. */
+double wallTime() {
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + 1e-6*tv.tv_usec;
+}
@@ -9,4 +9,8 @@ V mod(const V& a, const V& b);
 /** Tests if i is in [s,e]%N. */
 bool in_range(const int i, const int s, const int e, const int N);
 
+/** Wall-clock time in seconds.
+ *  Unlike clock(), this does not add up the time of concurrent threads. */
+double wallTime();
+
 #endif
@@ -106,3 +106,91 @@ int median(std::vector<int> & pts,
 	std::nth_element(pts.begin()+start, pts.begin()+mid, pts.begin()+end+1, comp);
 	return mid;
 }
+
+
+/** Index of the cell (x,y) along the Hilbert curve filling
+ *  a 2^16 x 2^16 grid. x, y must be in [0, 2^16). */
+unsigned int hilbertIndex(unsigned int x, unsigned int y) {
+	const unsigned int N = 1u << 16;
+	unsigned int d = 0;
+	for (unsigned int s = N/2; s > 0; s /= 2) {
+		const unsigned int rx = (x & s) > 0;
+		const unsigned int ry = (y & s) > 0;
+		d += s * s * ((3 * rx) ^ ry);
+
+		// rotate the quadrant
+		if (ry == 0) {
+			if (rx == 1) {
+				x = N-1 - x;
+				y = N-1 - y;
+			}
+			std::swap(x, y);
+		}
+	}
+	return d;
+}
+
+
+/** Sorts the pts b/w [start, end] (inclusive) indices
+ *  along a Hilbert curve through their bounding box.
+ *  Points close on the curve are close in the plane. */
+void hilbertSort(std::vector<int> & pts,
+		const std::vector<boost::shared_ptr<Eigen::Vector2d> > *ptrs,
+		int start, int end) {
+	if (end <= start) return;
+
+	Eigen::Vector2d lo = *(ptrs->at(pts[start]));
+	Eigen::Vector2d hi = lo;
+	for (int i = start+1; i <= end; i += 1) {
+		lo = lo.cwiseMin(*(ptrs->at(pts[i])));
+		hi = hi.cwiseMax(*(ptrs->at(pts[i])));
+	}
+	Eigen::Vector2d ext = hi - lo;
+	const double scale = 65535.0 / std::max(std::max(ext.x(), ext.y()), 1e-300);
+
+	std::vector<std::pair<unsigned int, int> > keyed(end-start+1);
+	for (int i = start; i <= end; i += 1) {
+		const Eigen::Vector2d &p = *(ptrs->at(pts[i]));
+		keyed[i-start] = std::make_pair(hilbertIndex((unsigned int) ((p.x()-lo.x())*scale),
+				(unsigned int) ((p.y()-lo.y())*scale)), pts[i]);
+	}
+	std::sort(keyed.begin(), keyed.end());
+	for (int i = start; i <= end; i += 1)
+		pts[i] = keyed[i-start].second;
+}
+
+
+/** LSD radix sort of KEYS, carrying VALS. */
+void radixSort(std::vector<uint64_t> &keys, std::vector<int> &vals) {
+	const int n = keys.size();
+	const int BITS = 16, R = 1 << BITS;
+	uint64_t all_or = 0, all_and = ~(uint64_t) 0;
+	for (int i = 0; i < n; i += 1) {
+		all_or  |= keys[i];
+		all_and &= keys[i];
+	}
+
+	std::vector<uint64_t> keys2(n);
+	std::vector<int> vals2(n);
+	std::vector<int> count(R);
+	for (int shift = 0; shift < 64; shift += BITS) {
+		// the same digit in all the keys : nothing to do.
+		if (((all_or ^ all_and) >> shift & (R-1)) == 0) continue;
+
+		std::fill(count.begin(), count.end(), 0);
+		for (int i = 0; i < n; i += 1)
+			count[keys[i] >> shift & (R-1)] += 1;
+		for (int d = 0, sum = 0; d < R; d += 1) {
+			const int c = count[d];
+			count[d] = sum;
+			sum += c;
+		}
+		for (int i = 0; i < n; i += 1) {
+			const int j = count[keys[i] >> shift & (R-1)]++;
+			keys2[j] = keys[i];
+			vals2[j] = vals[i];
+		}
+		keys.swap(keys2);
+		vals.swap(vals2);
+	}
+}
@@ -4,6 +4,8 @@
 #include <Eigen/Dense>
 #include <Eigen/AlignedVector>
 #include <vector>
+#include <stdint.h>
+#include <cstring>
 #include <iostream>
 #include <algorithm>
 #include "misc.h"
@@ -106,4 +108,31 @@ int median(std::vector<int> & pts,
 		const std::vector<boost::shared_ptr<Eigen::Vector2d> > *ptrs,
 		int start, int end, int comp_coord=0);
 
+
+
+/** Index of the cell (x,y) along the Hilbert curve filling
+ *  a 2^16 x 2^16 grid. x, y must be in [0, 2^16). */
+unsigned int hilbertIndex(unsigned int x, unsigned int y);
+
+/** Sorts the pts b/w [start, end] (inclusive) indices
+ *  along a Hilbert curve through their bounding box.
+ *  Points close on the curve are close in the plane. */
+void hilbertSort(std::vector<int> & pts,
+		const std::vector<boost::shared_ptr<Eigen::Vector2d> > *ptrs,
+		int start, int end);
+
+
+/** Sorts KEYS in increasing order, and permutes VALS along with them :
+ *  LSD radix sort on 16 bit digits, stable, O(n) per digit. The digits
+ *  which are the same for all the keys are skipped. */
+void radixSort(std::vector<uint64_t> &keys, std::vector<int> &vals);
+
+/** Key of a non-negative double for radixSort : its bits, which are
+ *  ordered as the doubles are. */
+inline uint64_t radixKey(double x) {
+	uint64_t k;
+	std::memcpy(&k, &x, sizeof(k));
+	return k;
+}
+
 #endif